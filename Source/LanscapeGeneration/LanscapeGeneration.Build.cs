@@ -41,7 +41,10 @@ public class LanscapeGeneration : ModuleRules
 				// ... add private dependencies that you statically link with here ... 
 				"UnrealEd",
 				"Blutility",
-				"UMG"
+				"UMG",
+				"Landscape",
+				"Sockets",
+				"Networking"
 			}
 			);
 		
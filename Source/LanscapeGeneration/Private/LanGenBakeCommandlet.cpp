@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenBakeCommandlet.h"
+#include "LanGenBakeCoordinator.h"
+#include "LanGenBakeWorker.h"
+#include "LanGenHeightfieldFile.h"
+#include "Misc/Paths.h"
+
+ULanGenBakeCommandlet::ULanGenBakeCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 ULanGenBakeCommandlet::Main(const FString& params)
+{
+    const TCHAR* line = *params;
+    int32 port = 0;
+    FParse::Value(line, TEXT("port="), port);
+
+    if (FParse::Param(line, TEXT("worker"))) {
+        int32 id = 0;
+        FString host;
+        FParse::Value(line, TEXT("id="), id);
+        FParse::Value(line, TEXT("host="), host);
+        ULanGenBakeWorker* worker = NewObject<ULanGenBakeWorker>();
+        FParse::Value(line, TEXT("idle="), worker->idleTimeout);
+        return worker->Run(host, port, id) ? 0 : 1;
+    }
+
+    ULanGenBakeCoordinator* coordinator = NewObject<ULanGenBakeCoordinator>();
+    int32 size = 4096, sizeX = 0, sizeY = 0;
+    float scale = 512;
+    FString output = FPaths::ProjectSavedDir() / TEXT("LanGen") / TEXT("Bake.lghf");
+    FParse::Value(line, TEXT("size="), size);
+    sizeX = sizeY = size;
+    FParse::Value(line, TEXT("sizeX="), sizeX);
+    FParse::Value(line, TEXT("sizeY="), sizeY);
+    FParse::Value(line, TEXT("scale="), scale);
+    FParse::Value(line, TEXT("output="), output);
+    FParse::Value(line, TEXT("tile="), coordinator->tileSize);
+    FParse::Value(line, TEXT("workers="), coordinator->workers);
+    FParse::Value(line, TEXT("retries="), coordinator->maxRetries);
+    FParse::Value(line, TEXT("seed="), coordinator->noise.seed);
+    FParse::Value(line, TEXT("octaves="), coordinator->noise.octaves);
+    coordinator->noise.tileX = coordinator->noise.tileY = scale;
+    coordinator->noise.adaptive = !FParse::Param(line, TEXT("exact"));
+    coordinator->port = port;
+    FParse::Value(line, TEXT("bind="), coordinator->bindAddress);
+    coordinator->spawnWorkers = !FParse::Param(line, TEXT("noSpawn"));
+
+    if (!coordinator->Bake(sizeX, sizeY)) {
+        UE_LOG(LogTemp, Error, TEXT("LanGenBake: bake failed"));
+        return 1;
+    }
+    FLanGenStats stats = coordinator->GetLastStats();
+    UE_LOG(LogTemp, Display, TEXT("LanGenBake: %dx%d in %.1fms, %.2f Mpx/s overall"),
+        sizeX, sizeY, stats.totalMs, stats.totalMs > 0 ? (double)sizeX * sizeY / stats.totalMs / 1000.0 : 0.0);
+
+    ULanGenHeightfieldFile* file = NewObject<ULanGenHeightfieldFile>();
+    if (!file->WriteHeights(output, coordinator->HeightsView(), sizeX, sizeY)) {
+        UE_LOG(LogTemp, Error, TEXT("LanGenBake: could not write %s"), *output);
+        return 1;
+    }
+    UE_LOG(LogTemp, Display, TEXT("LanGenBake: wrote %s"), *output);
+    return 0;
+}
@@ -0,0 +1,273 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenBakeCoordinator.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "Misc/Paths.h"
+
+bool ULanGenBakeCoordinator::Bake(int x, int y)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_Bake);
+    stats.Reset();
+    FLanGenStageTimer timer(stats.totalMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
+    workerStats.Reset();
+    heights.Reset();
+    if (x <= 0 || y <= 0 || tileSize <= 0 || workers <= 0) return false;
+
+    ISocketSubsystem* subsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TSharedRef<FInternetAddr> address = subsystem->CreateInternetAddr();
+    bool isValid = true;
+    if (bindAddress.IsEmpty()) address->SetLoopbackAddress();
+    else address->SetIp(*bindAddress, isValid);
+    if (!isValid) {
+        UE_LOG(LogTemp, Error, TEXT("LanGenBake: bad bind address %s"), *bindAddress);
+        return false;
+    }
+    address->SetPort(port);
+    FSocket* listen = subsystem->CreateSocket(NAME_Stream, TEXT("LanGenBake"), false);
+    if (!listen) return false;
+    if (!listen->Bind(*address) || !listen->Listen(workers * 2)) {
+        subsystem->DestroySocket(listen);
+        return false;
+    }
+    listen->SetNonBlocking(true);
+    int32 listenPort = listen->GetPortNo();
+    // workers spawned here reach a wildcard bind through loopback
+    FString listenHost = bindAddress.IsEmpty() || bindAddress == TEXT("0.0.0.0") ? TEXT("127.0.0.1") : bindAddress;
+    UE_LOG(LogTemp, Display, TEXT("LanGenBake: listening on %s:%d"), bindAddress.IsEmpty() ? TEXT("127.0.0.1") : *bindAddress, listenPort);
+
+    lanX = x;
+    lanY = y;
+    tilesX = FMath::DivideAndRoundUp(x, tileSize);
+    tilesY = FMath::DivideAndRoundUp(y, tileSize);
+    heights.SetNumZeroed(x * y);
+
+    TArray<workerSlot> slots;
+    TArray<FLanGenBakeChannel> unnamed;
+    TArray<double> unnamedSince;
+    TArray<int32> queue, attempts;
+    int32 done = 0, tileCount = tilesX * tilesY;
+    bool isOk = true;
+    double lastActivity = FPlatformTime::Seconds();
+    queue.Reserve(tileCount);
+    for (int32 i = 0; i < tileCount; ++i) queue.Add(i);
+    attempts.Init(0, tileCount);
+    if (spawnWorkers) {
+        // a slot that fails to start stays dead and goes through the respawn path like a lost worker
+        int started = 0;
+        slots.SetNum(workers);
+        for (int32 i = 0; i < workers; ++i) {
+            slots[i].id = i;
+            started += Spawn(slots[i], listenHost, listenPort);
+        }
+        if (started == 0) {
+            UE_LOG(LogTemp, Error, TEXT("LanGenBake: no worker could be started"));
+            isOk = false;
+        }
+    }
+
+    while (isOk && done < tileCount) {
+        bool isBusy = false;
+        double now = FPlatformTime::Seconds();
+
+        // new links stay unnamed until their hello says which worker they are
+        bool hasPending = false;
+        while (listen->HasPendingConnection(hasPending) && hasPending) {
+            FSocket* socket = listen->Accept(TEXT("LanGenBakeWorker"));
+            if (!socket) break;
+            socket->SetNonBlocking(true);
+            unnamed.Add(FLanGenBakeChannel(socket));
+            unnamedSince.Add(now);
+        }
+        auto dropUnnamed = [&](int i) {
+            unnamed[i].Close();
+            unnamed.RemoveAtSwap(i);
+            unnamedSince.RemoveAtSwap(i);
+        };
+        for (int i = unnamed.Num() - 1; i >= 0; --i) {
+            LanGenBakeMessage::Type type;
+            TArray<uint8> payload;
+            int32 id = INDEX_NONE;
+            if (!unnamed[i].Receive(type, payload)) {
+                // a port probe or a client that never says hello must not sit on the port, or on a growing inbox
+                if (unnamed[i].isBroken || now - unnamedSince[i] > connectTimeout) dropUnnamed(i);
+                continue;
+            }
+            if (type != LanGenBakeMessage::Hello || !LanGenBakeUnpack(payload, id) || id < 0) {
+                dropUnnamed(i);
+                continue;
+            }
+            workerSlot* slot = slots.FindByPredicate([&](const workerSlot& j) { return j.id == id; });
+            if (!slot) {
+                slot = &slots.AddDefaulted_GetRef();
+                slot->id = id;
+            }
+            slot->channel.Close();
+            slot->channel = unnamed[i];
+            slot->isAlive = true;
+            StatsOf(id);
+            unnamed.RemoveAtSwap(i);
+            unnamedSince.RemoveAtSwap(i);
+            isBusy = true;
+        }
+
+        for (workerSlot& slot : slots) {
+            // a spawned process that never called back
+            if (!slot.channel.socket) {
+                if (slot.proc.IsValid() && (!FPlatformProcess::IsProcRunning(slot.proc) || now - slot.spawnedAt > connectTimeout))
+                    Drop(slot, queue, attempts, TEXT("never connected"));
+                continue;
+            }
+
+            LanGenBakeMessage::Type type;
+            TArray<uint8> payload;
+            while (slot.channel.Receive(type, payload)) {
+                isBusy = true;
+                lastActivity = now;
+                FLanGenBakeWorkerStats& workerStat = StatsOf(slot.id);
+                if (type == LanGenBakeMessage::Result) {
+                    FLanGenBakeResult result;
+                    FLanGenBakeJob job = MakeJob(slot.tile);
+                    if (!LanGenBakeUnpack(payload, result) || result.tile != slot.tile || result.heights.Num() != job.x * job.y) {
+                        Drop(slot, queue, attempts, TEXT("bad result"));
+                        break;
+                    }
+                    // rows are contiguous along y in both layouts
+                    for (int i = 0; i < job.x; ++i)
+                        FMemory::Memcpy(heights.GetData() + (job.x0 + i) * lanY + job.y0, result.heights.GetData() + i * job.y, job.y * sizeof(float));
+                    ++workerStat.tilesDone;
+                    workerStat.pixels += result.heights.Num();
+                    workerStat.computeMs += result.computeMs;
+                    workerStat.busyMs += (now - slot.sentAt) * 1000.0;
+                    stats.bytesTouched += payload.Num();
+                    slot.tile = INDEX_NONE;
+                    ++done;
+                }
+                else if (type == LanGenBakeMessage::Failed) {
+                    int32 tile = INDEX_NONE;
+                    FString reason;
+                    FMemoryReader reader(payload);
+                    reader << tile << reason;
+                    UE_LOG(LogTemp, Warning, TEXT("LanGenBake: worker %d failed tile %d: %s"), slot.id, slot.tile, *reason);
+                    ++workerStat.tilesFailed;
+                    if (slot.tile != INDEX_NONE) queue.Add(slot.tile);
+                    slot.tile = INDEX_NONE;
+                }
+            }
+            if (!slot.isAlive) continue;
+            if (slot.channel.isBroken || (slot.proc.IsValid() && !FPlatformProcess::IsProcRunning(slot.proc)))
+                Drop(slot, queue, attempts, TEXT("link lost"));
+            else if (slot.tile != INDEX_NONE && now - slot.sentAt > jobTimeout)
+                Drop(slot, queue, attempts, TEXT("timed out"));
+        }
+
+        // a tile past its retries fails the bake; anything else gets handed out
+        for (int32 tile : queue) {
+            if (attempts[tile] > maxRetries) {
+                UE_LOG(LogTemp, Error, TEXT("LanGenBake: tile %d failed %d times"), tile, attempts[tile]);
+                isOk = false;
+            }
+        }
+        for (workerSlot& slot : slots) {
+            if (!isOk || queue.Num() == 0) break;
+            if (!slot.isAlive || slot.tile != INDEX_NONE) continue;
+            slot.tile = queue.Pop(false);
+            ++attempts[slot.tile];
+            slot.sentAt = now;
+            FLanGenBakeJob job = MakeJob(slot.tile);
+            if (!slot.channel.Send(LanGenBakeMessage::Job, LanGenBakePack(job), jobTimeout)) Drop(slot, queue, attempts, TEXT("send failed"));
+            isBusy = true;
+        }
+
+        // lost workers come back while they have respawns left; a link that hasn't said hello is no worker yet
+        int alive = 0;
+        for (workerSlot& slot : slots) {
+            if (!slot.isAlive && !slot.proc.IsValid() && spawnWorkers && slot.respawns < maxRetries && done < tileCount) {
+                ++slot.respawns;
+                Spawn(slot, listenHost, listenPort);
+            }
+            alive += slot.isAlive || slot.proc.IsValid();
+        }
+        if (alive == 0 && (spawnWorkers || now - lastActivity > connectTimeout)) {
+            UE_LOG(LogTemp, Error, TEXT("LanGenBake: no workers left with %d tiles to go"), tileCount - done);
+            isOk = false;
+        }
+        if (!isBusy) FPlatformProcess::Sleep(0.001);
+    }
+
+    for (workerSlot& slot : slots) {
+        slot.channel.Send(LanGenBakeMessage::Quit, TArray<uint8>(), 1);
+        slot.channel.Close();
+        if (slot.proc.IsValid()) {
+            // workers leave on quit; one that doesn't within a few seconds is stuck
+            double end = FPlatformTime::Seconds() + 5;
+            while (FPlatformProcess::IsProcRunning(slot.proc) && FPlatformTime::Seconds() < end) FPlatformProcess::Sleep(0.01);
+            if (FPlatformProcess::IsProcRunning(slot.proc)) FPlatformProcess::TerminateProc(slot.proc, true);
+            FPlatformProcess::CloseProc(slot.proc);
+        }
+    }
+    for (FLanGenBakeChannel& i : unnamed) i.Close();
+    listen->Close();
+    subsystem->DestroySocket(listen);
+
+    for (FLanGenBakeWorkerStats& i : workerStats) {
+        i.pixelsPerSecond = i.busyMs > 0 ? i.pixels / (i.busyMs / 1000.0) : 0;
+        UE_LOG(LogTemp, Display, TEXT("LanGenBake: worker %d tiles %d failed %d compute %.1fms busy %.1fms %.2f Mpx/s"),
+            i.worker, i.tilesDone, i.tilesFailed, i.computeMs, i.busyMs, i.pixelsPerSecond / 1e6);
+    }
+    stats.pixelsWritten = isOk ? (int64)x * y : 0;
+    if (!isOk) heights.Empty();
+    return isOk;
+}
+
+bool ULanGenBakeCoordinator::Spawn(workerSlot& slot, const FString& listenHost, int32 listenPort)
+{
+    // same executable and project, headless, as a commandlet
+    FString params = FString::Printf(TEXT("\"%s\" -run=LanGenBake -worker -host=%s -port=%d -id=%d -unattended -nullrhi -nosplash -nopause"),
+        *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *listenHost, listenPort, slot.id);
+    slot.proc = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *params, false, true, true, nullptr, 0, nullptr, nullptr);
+    slot.spawnedAt = FPlatformTime::Seconds();
+    if (!slot.proc.IsValid()) UE_LOG(LogTemp, Error, TEXT("LanGenBake: could not start worker %d"), slot.id);
+    return slot.proc.IsValid();
+}
+
+void ULanGenBakeCoordinator::Drop(workerSlot& slot, TArray<int32>& queue, TArray<int32>& attempts, const TCHAR* reason)
+{
+    UE_LOG(LogTemp, Warning, TEXT("LanGenBake: dropping worker %d (%s)"), slot.id, reason);
+    if (slot.tile != INDEX_NONE) {
+        queue.Add(slot.tile);
+        ++StatsOf(slot.id).tilesFailed;
+    }
+    slot.tile = INDEX_NONE;
+    slot.isAlive = false;
+    slot.channel.Close();
+    slot.channel = FLanGenBakeChannel();
+    if (slot.proc.IsValid()) {
+        FPlatformProcess::TerminateProc(slot.proc, true);
+        FPlatformProcess::CloseProc(slot.proc);
+        slot.proc.Reset();
+    }
+}
+
+FLanGenBakeWorkerStats& ULanGenBakeCoordinator::StatsOf(int32 id)
+{
+    FLanGenBakeWorkerStats* res = workerStats.FindByPredicate([&](const FLanGenBakeWorkerStats& i) { return i.worker == id; });
+    if (res) return *res;
+    FLanGenBakeWorkerStats& added = workerStats.AddDefaulted_GetRef();
+    added.worker = id;
+    return added;
+}
+
+FLanGenBakeJob ULanGenBakeCoordinator::MakeJob(int32 tile) const
+{
+    FLanGenBakeJob res;
+    res.tile = tile;
+    res.x0 = tile / tilesY * tileSize;
+    res.y0 = tile % tilesY * tileSize;
+    res.x = FMath::Min(tileSize, lanX - res.x0);
+    res.y = FMath::Min(tileSize, lanY - res.y0);
+    res.noise = noise;
+    return res;
+}
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenBakeProtocol.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+FArchive& operator<<(FArchive& ar, FLanGenBakeNoise& in)
+{
+    uint8 type = (uint8)in.type;
+    ar << in.seed << in.tileX << in.tileY << in.octaves << type << in.lacunarity << in.persistence << in.z
+        << in.adaptive << in.nyquistMargin << in.cubicUpsample;
+    in.type = (ELanGenNoiseType)type;
+    return ar;
+}
+
+FArchive& operator<<(FArchive& ar, FLanGenBakeJob& in)
+{
+    return ar << in.tile << in.x0 << in.y0 << in.x << in.y << in.noise;
+}
+
+FArchive& operator<<(FArchive& ar, FLanGenBakeResult& in)
+{
+    // one memcpy for the tile instead of a serialize call per height
+    ar << in.tile << in.computeMs;
+    in.heights.BulkSerialize(ar);
+    return ar;
+}
+
+bool FLanGenBakeChannel::Send(LanGenBakeMessage::Type type, const TArray<uint8>& payload, float seconds)
+{
+    if (!socket || isBroken) return false;
+    uint8 head[5];
+    uint32 size = payload.Num();
+    FMemory::Memcpy(head, &size, 4);
+    head[4] = type;
+
+    // non blocking sockets take what fits; keep offering the rest until a peer that stopped reading runs out the deadline
+    double end = FPlatformTime::Seconds() + seconds;
+    auto sendAll = [&](const uint8* data, int32 num) {
+        while (num > 0) {
+            int32 sent = 0;
+            if (!socket->Send(data, num, sent)) {
+                if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK) return false;
+                double left = end - FPlatformTime::Seconds();
+                if (left <= 0) return false;
+                socket->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::FromSeconds(FMath::Min(left, 0.1)));
+                continue;
+            }
+            data += sent;
+            num -= sent;
+        }
+        return true;
+    };
+    if (!sendAll(head, 5) || !sendAll(payload.GetData(), payload.Num())) isBroken = true;
+    return !isBroken;
+}
+
+bool FLanGenBakeChannel::Receive(LanGenBakeMessage::Type& type, TArray<uint8>& payload)
+{
+    if (!socket || isBroken) return false;
+    uint32 pending = 0;
+    while (socket->HasPendingData(pending) && pending > 0) {
+        int32 start = inbox.Num(), read = 0;
+        inbox.AddUninitialized(pending);
+        if (!socket->Recv(inbox.GetData() + start, pending, read)) {
+            inbox.SetNum(start, false);
+            isBroken = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK;
+            break;
+        }
+        inbox.SetNum(start + read, false);
+        if (read == 0) break;
+    }
+    if (socket->GetConnectionState() == SCS_ConnectionError) isBroken = true;
+    // a peer that closed cleanly reads as readable with nothing pending; a peek then sees the end of stream
+    if (!isBroken && pending == 0 && socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero())) {
+        uint8 peek;
+        int32 read = 0;
+        if (!socket->Recv(&peek, 1, read, ESocketReceiveFlags::Peek) || read == 0) isBroken = true;
+    }
+
+    if (inbox.Num() < 5) return false;
+    uint32 size;
+    FMemory::Memcpy(&size, inbox.GetData(), 4);
+    if (size > MAX_PAYLOAD) {
+        isBroken = true;
+        return false;
+    }
+    if ((uint32)inbox.Num() < 5 + size) return false;
+    type = (LanGenBakeMessage::Type)inbox[4];
+    payload.SetNumUninitialized(size);
+    FMemory::Memcpy(payload.GetData(), inbox.GetData() + 5, size);
+    inbox.RemoveAt(0, 5 + size, false);
+    return true;
+}
+
+bool FLanGenBakeChannel::Wait(LanGenBakeMessage::Type& type, TArray<uint8>& payload, float seconds)
+{
+    double end = FPlatformTime::Seconds() + seconds;
+    while (!isBroken) {
+        if (Receive(type, payload)) return true;
+        double left = end - FPlatformTime::Seconds();
+        if (left <= 0) break;
+        socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(FMath::Min(left, 0.1)));
+    }
+    return false;
+}
+
+void FLanGenBakeChannel::Close()
+{
+    if (socket) {
+        socket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(socket);
+    }
+    socket = nullptr;
+    inbox.Empty();
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenBakeWorker.h"
+#include "LanGenNoiseObject.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+bool ULanGenBakeWorker::Run(const FString& host, int32 port, int32 id)
+{
+    ISocketSubsystem* subsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TSharedRef<FInternetAddr> address = subsystem->CreateInternetAddr();
+    bool isValid = true;
+    if (host.IsEmpty()) address->SetLoopbackAddress();
+    else address->SetIp(*host, isValid);
+    if (!isValid) {
+        UE_LOG(LogTemp, Error, TEXT("LanGenBake: worker %d got a bad host %s"), id, *host);
+        return false;
+    }
+    address->SetPort(port);
+
+    // the coordinator may still be coming up when we are started by hand
+    FSocket* socket = nullptr;
+    double end = FPlatformTime::Seconds() + connectTimeout;
+    while (!socket && FPlatformTime::Seconds() < end) {
+        socket = subsystem->CreateSocket(NAME_Stream, TEXT("LanGenBakeWorker"), false);
+        if (socket && socket->Connect(*address)) break;
+        if (socket) subsystem->DestroySocket(socket);
+        socket = nullptr;
+        FPlatformProcess::Sleep(0.25);
+    }
+    if (!socket) {
+        UE_LOG(LogTemp, Error, TEXT("LanGenBake: worker %d could not reach %s"), id, *address->ToString(true));
+        return false;
+    }
+    socket->SetNonBlocking(true);
+    FLanGenBakeChannel channel(socket);
+    channel.Send(LanGenBakeMessage::Hello, LanGenBakePack(id), idleTimeout);
+
+    bool isQuit = false;
+    double lastHeard = FPlatformTime::Seconds();
+    while (!isQuit && !channel.isBroken) {
+        LanGenBakeMessage::Type type;
+        TArray<uint8> payload;
+        if (!channel.Wait(type, payload, 1)) {
+            // a coordinator that hangs or sits behind a dead link never closes the socket
+            if (FPlatformTime::Seconds() - lastHeard <= idleTimeout) continue;
+            UE_LOG(LogTemp, Warning, TEXT("LanGenBake: worker %d heard nothing for %.0fs, leaving"), id, idleTimeout);
+            break;
+        }
+        lastHeard = FPlatformTime::Seconds();
+        if (type == LanGenBakeMessage::Quit) {
+            isQuit = true;
+        }
+        else if (type == LanGenBakeMessage::Job) {
+            FLanGenBakeJob job;
+            FLanGenBakeResult result;
+            if (LanGenBakeUnpack(payload, job) && Bake(job, result)) {
+                // a hung coordinator stops reading; the deadline turns that into a broken link instead of a stuck worker
+                channel.Send(LanGenBakeMessage::Result, LanGenBakePack(result), idleTimeout);
+            }
+            else {
+                FString reason = TEXT("empty field");
+                TArray<uint8> failed;
+                FMemoryWriter writer(failed);
+                writer << job.tile << reason;
+                channel.Send(LanGenBakeMessage::Failed, failed, idleTimeout);
+            }
+        }
+    }
+    channel.Close();
+    return isQuit;
+}
+
+bool ULanGenBakeWorker::Bake(const FLanGenBakeJob& job, FLanGenBakeResult& out)
+{
+    if (!noise) noise = NewObject<ULanGenNoiseObject>(this);
+    if (!noise->IsSeeded() || noise->seed != job.noise.seed) noise->InitSeed(job.noise.seed);
+    noise->nyquistMargin = job.noise.nyquistMargin;
+    noise->cubicUpsample = job.noise.cubicUpsample;
+
+    double start = FPlatformTime::Seconds();
+    out.tile = job.tile;
+    out.heights = noise->FbmRegion(job.x0, job.y0, job.x, job.y, job.noise.tileX, job.noise.tileY, job.noise.octaves, job.noise.type,
+        job.noise.lacunarity, job.noise.persistence, job.noise.z, job.noise.adaptive);
+    out.computeMs = (FPlatformTime::Seconds() - start) * 1000.0;
+    return out.heights.Num() == job.x * job.y && out.heights.Num() > 0;
+}
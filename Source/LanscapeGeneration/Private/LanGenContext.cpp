@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenContext.h"
+#include "LanscapeGeneration.h"
+#include "LanGenTurtleProgram.h"
+#include "UObject/Package.h"
+
+FLanGenContext& FLanGenContext::Get()
+{
+    return FModuleManager::GetModuleChecked<FLanscapeGenerationModule>("LanscapeGeneration").GetContext();
+}
+
+UObject* FLanGenContext::Shared(UClass* type)
+{
+    UObject*& res = shared.FindOrAdd(type);
+    if (!res) res = NewObject<UObject>(GetTransientPackage(), type);
+    return res;
+}
+
+const TArray<int>& FLanGenContext::Permutation(FName kind, int32 seed, TFunctionRef<void(TArray<int>&)> build)
+{
+    TArray<TPair<int32, TArray<int>>>& tables = permutations.FindOrAdd(kind);
+    for (TPair<int32, TArray<int>>& i : tables) {
+        if (i.Key == seed) return i.Value;
+    }
+    if (tables.Num() >= MAX_SEEDS) tables.RemoveAt(0);
+    TPair<int32, TArray<int>>& added = tables.AddDefaulted_GetRef();
+    added.Key = seed;
+    build(added.Value);
+    return added.Value;
+}
+
+TSharedPtr<FLanGenTurtleProgram> FLanGenContext::FindProgram(const FLanGenProgramKey& key)
+{
+    for (int i = 0; i < programs.Num(); ++i) {
+        if (!(programs[i].key == key)) continue;
+        programEntry entry = programs[i];
+        programs.RemoveAt(i);
+        programs.Add(entry);
+        return entry.program;
+    }
+    return nullptr;
+}
+
+void FLanGenContext::AddProgram(const FLanGenProgramKey& key, const TSharedRef<FLanGenTurtleProgram>& program)
+{
+    // a program can hold hundreds of megabytes of ops, so only the few most recent grammars stay
+    programs.RemoveAll([&](const programEntry& i) { return i.key == key; });
+    if (programs.Num() >= MAX_PROGRAMS) programs.RemoveAt(0);
+    programs.Add(programEntry{ key, program });
+}
+
+void FLanGenContext::SwapBuffer(FName name, FIntPoint oldSize, FIntPoint newSize, TArray<FColor>& inOut)
+{
+    if (oldSize == newSize) return;
+    TArray<FColor> parked = MoveTemp(inOut);
+    int found = buffers.IndexOfByPredicate([&](const bufferEntry& i) { return i.name == name && i.size == newSize; });
+    if (found != INDEX_NONE) {
+        inOut = MoveTemp(buffers[found].data);
+        buffers.RemoveAt(found);
+    }
+    if (parked.Max() == 0) return;
+    if (buffers.Num() >= MAX_BUFFERS) buffers.RemoveAt(0);
+    buffers.Add(bufferEntry{ name, oldSize, MoveTemp(parked) });
+}
+
+void FLanGenContext::Release()
+{
+    shared.Empty();
+    permutations.Empty();
+    programs.Empty();
+    buffers.Empty();
+}
+
+void FLanGenContext::AddReferencedObjects(FReferenceCollector& collector)
+{
+    collector.AddReferencedObjects(shared);
+}
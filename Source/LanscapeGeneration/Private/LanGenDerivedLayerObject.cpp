@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenDerivedLayerObject.h"
+#include "LanGenNoiseObject.h"
+#include "Async/ParallelFor.h"
+#include "Misc/MemStack.h"
+#include "LandscapeProxy.h"
+#include "LandscapeInfo.h"
+#include "LandscapeEdit.h"
+#include "LandscapeLayerInfoObject.h"
+
+void ULanGenDerivedLayerObject::Compute(const TArray<FColor>& heightmap, int x, int y, float heightScale, ULanGenNoiseObject* noise)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_DerivedLayers);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Derived);
+    stats.Reset();
+    FLanGenStageTimer timer(stats.totalMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
+    if (x <= 0 || y <= 0 || heightmap.Num() != x * y) return;
+    if (noise && !noise->IsSeeded()) noise = nullptr;
+
+    lanX = x;
+    lanY = y;
+    int layerCount = layers.Num(), blockCount = FMath::DivideAndRoundUp(x, BLOCK_ROWS);
+    normalMap.SetNumUninitialized(x * y);
+    slope.SetNumUninitialized(x * y);
+    curvature.SetNumUninitialized(x * y);
+    weights.SetNumUninitialized(x * y * layerCount);
+
+    ParallelFor(blockCount, [&](int32 block) {
+        FMemMark memMark(FMemStack::Get());
+        // one row of weights per layer, then their sum
+        TArray<float, TMemStackAllocator<>> layerWeight, sum;
+        layerWeight.SetNumUninitialized(layerCount * y);
+        sum.SetNumUninitialized(y);
+        for (int i = block * BLOCK_ROWS; i < FMath::Min(x, (block + 1) * BLOCK_ROWS); ++i) {
+            // clamp at the border; neighbour rows of this row
+            const FColor* row = heightmap.GetData() + i * y;
+            const FColor* prev = heightmap.GetData() + FMath::Max(i - 1, 0) * y;
+            const FColor* next = heightmap.GetData() + FMath::Min(i + 1, x - 1) * y;
+            int base = i * y;
+            FColor* rowNormal = normalMap.GetData() + base;
+            float* rowSlope = slope.GetData() + base;
+            float* rowCurvature = curvature.GetData() + base;
+
+            // gradient, normal, slope, curvature; only the two border columns clamp, so the interior loop has no branches
+            auto derive = [&](int j, int left, int right) {
+                float dx = (next[j].R - prev[j].R) * 0.5f * heightScale,
+                    dy = (row[right].R - row[left].R) * 0.5f * heightScale,
+                    gradient = dx * dx + dy * dy,
+                    inverse = FMath::InvSqrt(gradient + 1);
+                rowNormal[j] = FColor(
+                    FMath::RoundToInt((-dx * inverse * 0.5f + 0.5f) * 255),
+                    FMath::RoundToInt((-dy * inverse * 0.5f + 0.5f) * 255),
+                    FMath::RoundToInt((inverse * 0.5f + 0.5f) * 255));
+                rowSlope[j] = FMath::RadiansToDegrees(FMath::Atan(FMath::Sqrt(gradient)));
+                rowCurvature[j] = (next[j].R + prev[j].R + row[right].R + row[left].R - 4 * row[j].R) * heightScale;
+            };
+            derive(0, 0, FMath::Min(1, y - 1));
+            for (int j = 1; j < y - 1; ++j) derive(j, j - 1, j + 1);
+            if (y > 1) derive(y - 1, y - 2, y - 1);
+
+            // weights; a straight loop over the row per layer, noise only for the layers that use it
+            FMemory::Memzero(sum.GetData(), y * sizeof(float));
+            for (int k = 0; k < layerCount; ++k) {
+                const FLanGenWeightLayer& layer = layers[k];
+                float* out = layerWeight.GetData() + k * y;
+                for (int j = 0; j < y; ++j)
+                    out[j] = Band(row[j].R, layer.minHeight, layer.maxHeight, layer.heightBlend) *
+                        Band(rowSlope[j], layer.minSlope, layer.maxSlope, layer.slopeBlend);
+                if (noise && layer.noiseAmount != 0) {
+                    for (int j = 0; j < y; ++j) {
+                        if (out[j] > 0) out[j] *= 1 + layer.noiseAmount * noise->PerlinNoise3D(FVector(i * layer.noiseScale, j * layer.noiseScale, k), 0);
+                    }
+                }
+                for (int j = 0; j < y; ++j) {
+                    out[j] = FMath::Clamp(out[j] * layer.strength, 0.0f, 1.0f);
+                    sum[j] += out[j];
+                }
+            }
+            for (int j = 0; j < y; ++j) sum[j] = (normalizeWeights && sum[j] > 0) ? 255 / sum[j] : 255;
+            for (int k = 0; k < layerCount; ++k) {
+                const float* in = layerWeight.GetData() + k * y;
+                uint8* out = weights.GetData() + k * x * y + base;
+                for (int j = 0; j < y; ++j) out[j] = FMath::RoundToInt(in[j] * sum[j]);
+            }
+        }
+    });
+
+    stats.pixelsRasterized = (int64)x * y;
+    stats.pixelsWritten = (int64)x * y;
+    stats.bytesTouched = (int64)x * y * (sizeof(FColor) * 2 + sizeof(float) * 2 + layerCount);
+}
+
+bool ULanGenDerivedLayerObject::WriteToLandscape(ALandscapeProxy* landscape, FIntPoint offset)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_WriteWeightmaps);
+    ULandscapeInfo* info = landscape ? landscape->GetLandscapeInfo() : nullptr;
+    if (!info || weights.Num() != lanX * lanY * layers.Num()) return false;
+
+    // our index is x * lanY + y, ie. rows of lanY; that is landscape Y rows with lanY wide X
+    FLandscapeEditDataInterface landscapeEdit(info);
+    for (int k = 0; k < layers.Num(); ++k) {
+        if (!layers[k].layerInfo) continue;
+        landscapeEdit.SetAlphaData(layers[k].layerInfo,
+            offset.X, offset.Y, offset.X + lanY - 1, offset.Y + lanX - 1,
+            weights.GetData() + k * lanX * lanY, lanY,
+            ELandscapeLayerPaintingRestriction::None, false, false);
+    }
+    landscapeEdit.Flush();
+    return true;
+}
+
+TArray<uint8> ULanGenDerivedLayerObject::GetWeightLayer(int layer) const
+{
+    TArray<uint8> res;
+    if (layer < 0 || layer >= layers.Num() || weights.Num() != lanX * lanY * layers.Num()) return res;
+    res.Append(weights.GetData() + layer * lanX * lanY, lanX * lanY);
+    return res;
+}
+
+float ULanGenDerivedLayerObject::Band(float value, float min, float max, float blend)
+{
+    if (blend <= 0) return (value >= min && value <= max) ? 1 : 0;
+    return FMath::Clamp((value - min) / blend + 1, 0.0f, 1.0f) * FMath::Clamp((max - value) / blend + 1, 0.0f, 1.0f);
+}
@@ -0,0 +1,227 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenDistanceField.h"
+#include "Misc/MemStack.h"
+#include "Async/ParallelFor.h"
+#include "Algo/BinarySearch.h"
+
+namespace {
+    /* 1d lower envelope of parabolas (i - q)^2 + cost(q) over the sampled q; out(i, q) gets the minimising q, -1 without samples */
+    template<typename CostType, typename OutType>
+    void LowerEnvelope(int len, int32* v, double* z, CostType cost, OutType out)
+    {
+        int k = -1;
+        double fq = 0, fv = 0;
+        for (int q = 0; q < len; ++q) {
+            if (!cost(q, fq)) continue;
+            fq += (double)q * q;
+            double s = 0;
+            while (k >= 0) {
+                cost(v[k], fv);
+                fv += (double)v[k] * v[k];
+                s = (fq - fv) / (2.0 * (q - v[k]));
+                if (s <= z[k]) --k;
+                else break;
+            }
+            ++k;
+            v[k] = q;
+            z[k] = (k == 0) ? -DBL_MAX : s;
+            z[k + 1] = DBL_MAX;
+        }
+        for (int i = 0, j = 0; i < len; ++i) {
+            if (k < 0) {
+                out(i, -1);
+                continue;
+            }
+            while (z[j + 1] < i) ++j;
+            out(i, v[j]);
+        }
+    }
+}
+
+void FLanGenDistanceField::NearestSeed(TArrayView<int32> nearest, int xLen, int yLen, bool parallel)
+{
+    check(nearest.Num() == xLen * yLen);
+    FMemMark memMark(FMemStack::Get());
+    TArray<int32, TMemStackAllocator<>> colSeed; // nearest seed y within the same column, -1 = none
+    colSeed.SetNumUninitialized(xLen * yLen);
+
+    // pass 1; along y, contiguous
+    ParallelFor(xLen, [&](int32 x) {
+        int base = x * yLen, last = -1;
+        for (int y = 0; y < yLen; ++y) {
+            if (nearest[base + y] != INDEX_NONE) last = y;
+            colSeed[base + y] = last;
+        }
+        last = -1;
+        for (int y = yLen - 1; y >= 0; --y) {
+            if (nearest[base + y] != INDEX_NONE) last = y;
+            if (last != -1 && (colSeed[base + y] == -1 || last - y < y - colSeed[base + y])) colSeed[base + y] = last;
+        }
+    }, !parallel);
+
+    // pass 2; lower envelope of parabolas along x, rows are split in chunks that own their envelope scratch
+    int chunkCount = parallel ? FMath::Min(yLen, 64) : 1,
+        chunkSize = FMath::DivideAndRoundUp(yLen, FMath::Max(chunkCount, 1));
+    ParallelFor(chunkCount, [&](int32 chunk) {
+        FMemMark chunkMark(FMemStack::Get());
+        TArray<int32, TMemStackAllocator<>> v;
+        TArray<double, TMemStackAllocator<>> z;
+        v.SetNumUninitialized(xLen);
+        z.SetNumUninitialized(xLen + 1);
+
+        for (int y = chunk * chunkSize; y < FMath::Min(yLen, (chunk + 1) * chunkSize); ++y) {
+            LowerEnvelope(xLen, v.GetData(), z.GetData(),
+                [&](int q, double& cost) {
+                    int qSeed = colSeed[q * yLen + y];
+                    if (qSeed == -1) return false;
+                    cost = (double)(qSeed - y) * (qSeed - y);
+                    return true;
+                },
+                [&](int i, int q) { nearest[i * yLen + y] = q < 0 ? INDEX_NONE : q * yLen + colSeed[q * yLen + y]; });
+        }
+    }, !parallel);
+}
+
+void FLanGenDistanceField::NearestPowerSeed(TArrayView<int32> nearest, TArrayView<const int32> radius, int xLen, int yLen, bool parallel)
+{
+    check(nearest.Num() == xLen * yLen && radius.Num() == xLen * yLen);
+    FMemMark memMark(FMemStack::Get());
+    TArray<int32, TMemStackAllocator<>> colSeed; // winning seed y within the same column, -1 = none
+    colSeed.SetNumUninitialized(xLen * yLen);
+    int chunkCount = parallel ? 64 : 1;
+
+    // pass 1; weighted seeds need the envelope along y too, not just the closest one either side
+    int colChunk = FMath::DivideAndRoundUp(xLen, chunkCount);
+    ParallelFor(chunkCount, [&](int32 chunk) {
+        FMemMark chunkMark(FMemStack::Get());
+        TArray<int32, TMemStackAllocator<>> v;
+        TArray<double, TMemStackAllocator<>> z;
+        v.SetNumUninitialized(yLen);
+        z.SetNumUninitialized(yLen + 1);
+        for (int x = chunk * colChunk; x < FMath::Min(xLen, (chunk + 1) * colChunk); ++x) {
+            int base = x * yLen;
+            LowerEnvelope(yLen, v.GetData(), z.GetData(),
+                [&](int q, double& cost) {
+                    if (nearest[base + q] == INDEX_NONE) return false;
+                    cost = -(double)radius[base + q] * radius[base + q];
+                    return true;
+                },
+                [&](int i, int q) { colSeed[base + i] = q; });
+        }
+    }, !parallel);
+
+    // pass 2; along x over the column winners
+    int rowChunk = FMath::DivideAndRoundUp(yLen, chunkCount);
+    ParallelFor(chunkCount, [&](int32 chunk) {
+        FMemMark chunkMark(FMemStack::Get());
+        TArray<int32, TMemStackAllocator<>> v;
+        TArray<double, TMemStackAllocator<>> z;
+        v.SetNumUninitialized(xLen);
+        z.SetNumUninitialized(xLen + 1);
+        for (int y = chunk * rowChunk; y < FMath::Min(yLen, (chunk + 1) * rowChunk); ++y) {
+            LowerEnvelope(xLen, v.GetData(), z.GetData(),
+                [&](int q, double& cost) {
+                    int qSeed = colSeed[q * yLen + y];
+                    if (qSeed == -1) return false;
+                    cost = (double)(qSeed - y) * (qSeed - y) - (double)radius[q * yLen + qSeed] * radius[q * yLen + qSeed];
+                    return true;
+                },
+                [&](int i, int q) { nearest[i * yLen + y] = q < 0 ? INDEX_NONE : q * yLen + colSeed[q * yLen + y]; });
+        }
+    }, !parallel);
+}
+
+void FLanGenSparseField::AddRect(int x0, int y0, int x1, int y1)
+{
+    if (x0 > x1 || y0 > y1) return;
+    // neighbouring ridge points mostly cover the same blocks
+    FIntRect rect(BlockOf(x0), BlockOf(y0), BlockOf(x1), BlockOf(y1));
+    if (rect == lastRect) return;
+    lastRect = rect;
+    for (int bx = rect.Min.X; bx <= rect.Max.X; ++bx)
+        for (int by = rect.Min.Y; by <= rect.Max.Y; ++by) blocks.Add(FIntPoint(bx, by));
+}
+
+void FLanGenSparseField::Build()
+{
+    blocks.Sort([](const FIntPoint& a, const FIntPoint& b) { return a.X != b.X ? a.X < b.X : a.Y < b.Y; });
+    int unique = 0;
+    for (int i = 0; i < blocks.Num(); ++i) {
+        if (unique == 0 || blocks[i] != blocks[unique - 1]) blocks[unique++] = blocks[i];
+    }
+    blocks.SetNum(unique, false);
+    nearest.Init(INDEX_NONE, unique * AREA);
+    lastRect = FIntRect(0, 0, -1, -1);
+}
+
+int FLanGenSparseField::Find(int x, int y) const
+{
+    FIntPoint block(BlockOf(x), BlockOf(y));
+    int slot = Algo::LowerBound(blocks, block, [](const FIntPoint& a, const FIntPoint& b) { return a.X != b.X ? a.X < b.X : a.Y < b.Y; });
+    if (slot >= blocks.Num() || blocks[slot] != block) return INDEX_NONE;
+    return slot * AREA + (x - block.X * BLOCK) * BLOCK + (y - block.Y * BLOCK);
+}
+
+void FLanGenSparseField::Resolve()
+{
+    FMemMark memMark(FMemStack::Get());
+    TArray<int32, TMemStackAllocator<>> colY, colId, byRow, v;
+    TArray<double, TMemStackAllocator<>> z;
+    colY.SetNumUninitialized(nearest.Num());
+    colId.SetNumUninitialized(nearest.Num());
+
+    // pass 1; nearest seed within the column, through each run of vertically adjacent blocks
+    for (int first = 0, last = 0; first < blocks.Num(); first = last) {
+        for (last = first + 1; last < blocks.Num() && blocks[last].X == blocks[first].X && blocks[last].Y == blocks[last - 1].Y + 1; ++last);
+        for (int lx = 0; lx < BLOCK; ++lx) {
+            int seedY = 0, seedId = INDEX_NONE;
+            for (int slot = first; slot < last; ++slot) {
+                for (int ly = 0; ly < BLOCK; ++ly) {
+                    int cell = slot * AREA + lx * BLOCK + ly;
+                    if (nearest[cell] != INDEX_NONE) seedY = blocks[slot].Y * BLOCK + ly, seedId = nearest[cell];
+                    colY[cell] = seedY;
+                    colId[cell] = seedId;
+                }
+            }
+            seedId = INDEX_NONE;
+            for (int slot = last - 1; slot >= first; --slot) {
+                for (int ly = BLOCK - 1; ly >= 0; --ly) {
+                    int cell = slot * AREA + lx * BLOCK + ly, y = blocks[slot].Y * BLOCK + ly;
+                    if (nearest[cell] != INDEX_NONE) seedY = y, seedId = nearest[cell];
+                    if (seedId != INDEX_NONE && (colId[cell] == INDEX_NONE || seedY - y < y - colY[cell])) colY[cell] = seedY, colId[cell] = seedId;
+                }
+            }
+        }
+    }
+
+    // pass 2; lower envelope of parabolas along x, through each run of horizontally adjacent blocks
+    byRow.SetNumUninitialized(blocks.Num());
+    for (int i = 0; i < blocks.Num(); ++i) byRow[i] = i;
+    byRow.Sort([&](int32 a, int32 b) { return blocks[a].Y != blocks[b].Y ? blocks[a].Y < blocks[b].Y : blocks[a].X < blocks[b].X; });
+    int longest = 0;
+    for (int first = 0, last = 0; first < byRow.Num(); first = last) {
+        for (last = first + 1; last < byRow.Num() && blocks[byRow[last]].Y == blocks[byRow[first]].Y && blocks[byRow[last]].X == blocks[byRow[last - 1]].X + 1; ++last);
+        longest = FMath::Max(longest, last - first);
+    }
+    v.SetNumUninitialized(longest * BLOCK);
+    z.SetNumUninitialized(longest * BLOCK + 1);
+
+    for (int first = 0, last = 0; first < byRow.Num(); first = last) {
+        for (last = first + 1; last < byRow.Num() && blocks[byRow[last]].Y == blocks[byRow[first]].Y && blocks[byRow[last]].X == blocks[byRow[last - 1]].X + 1; ++last);
+        int runY = blocks[byRow[first]].Y * BLOCK;
+        // q is relative to the run, so the cell of q is byRow[first + q / BLOCK]
+        auto cellOf = [&](int q, int ly) { return byRow[first + q / BLOCK] * AREA + (q % BLOCK) * BLOCK + ly; };
+        for (int ly = 0; ly < BLOCK; ++ly) {
+            int y = runY + ly;
+            LowerEnvelope((last - first) * BLOCK, v.GetData(), z.GetData(),
+                [&](int q, double& cost) {
+                    int qCell = cellOf(q, ly);
+                    if (colId[qCell] == INDEX_NONE) return false;
+                    cost = (double)(colY[qCell] - y) * (colY[qCell] - y);
+                    return true;
+                },
+                [&](int i, int q) { nearest[cellOf(i, ly)] = q < 0 ? INDEX_NONE : colId[cellOf(q, ly)]; });
+        }
+    }
+}
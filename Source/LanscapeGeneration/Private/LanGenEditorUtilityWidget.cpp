@@ -6,8 +6,9 @@
 #include <Runtime/Landscape/Classes/Landscape.h>
 #include <Landscape.h>
 #include "Math/UnrealMathUtility.h"
-#include "ImageUtils.h"
 #include "Math/Color.h"
+#include "LanGenPreviewTextureManager.h"
+#include "LanGenContext.h"
 
 #define SCR_LOG(x, ...) if(GEngine){GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Red, FString::Printf(TEXT(x), __VA_ARGS__));}
 #define CON_LOG(x, ...) UE_LOG(LogTemp, Warning, TEXT(x), __VA_ARGS__);
@@ -18,31 +19,68 @@ void ULanGenEditorUtilityWidget::ScrLog(FString text) { SCR_LOG("%s", *text); }
 
 UTexture2D* ULanGenEditorUtilityWidget::GenerateTexture(int x, int y, int tileX, int tileY, int generateParam)
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_GenerateTexture);
 	TArray<FColor> colorData;
 	int index = 0;
 	FVector2D location;
+	double noiseStart;
+	UTexture2D* texture = nullptr;
 
+	// zeroed counters first; the elevation object publishes its share and ours goes on top at the end
+	stats.Reset();
+	stats.Publish();
 	switch (generateParam) {
 	case 0: colorData = GenerateElevationMap(x, y); break;
 	case 1: colorData.Init(FColor::Black, x * y); break; //noise only
-	case 2: colorData = GenerateElevationMap(x, y); goto create; //elevation only
+	case 2: colorData = GenerateElevationMap(x, y); break; //elevation only
 	}
-	ConLog("noise creation");
-	for (int i = 0; i < x; ++i) {
-		for (int j = 0; j < y; ++j) {
-			index = (i * y) + j;
-			location.X = (float)i / tileX;
-			location.Y = (float)j / tileY;
-			colorData[index].R = GenerateFunction(location, colorData[index].R);
+	{
+		// the elevation object keeps its own stats; these cover noise and upload only, so CombineStats counts nothing twice
+		FLanGenStageTimer totalTimer(stats.totalMs);
+		FLanGenAllocationScope allocationScope(stats.allocations);
+		if (generateParam != 2) {
+			ConLog("noise creation");
+			noiseStart = FPlatformTime::Seconds();
+			{
+				TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_Noise);
+				SCOPE_CYCLE_COUNTER(STAT_LanGen_Noise);
+				for (int i = 0; i < x; ++i) {
+					for (int j = 0; j < y; ++j) {
+						index = (i * y) + j;
+						location.X = (float)i / tileX;
+						location.Y = (float)j / tileY;
+						colorData[index].R = GenerateFunction(location, colorData[index].R);
+					}
+				}
+			}
+			stats.noiseMs = (FPlatformTime::Seconds() - noiseStart) * 1000.0;
+			stats.pixelsRasterized += (int64)x * y;
+			stats.pixelsWritten += (int64)x * y;
+			stats.bytesTouched += (int64)x * y * sizeof(FColor) * 2;
 		}
+
+		ConLog(FString::FromInt(colorData.Num()));
+		// reuse one transient texture per size and only upload what changed; the manager outlives the widget
+		if (!previewTextures) previewTextures = FLanGenContext::Get().Shared<ULanGenPreviewTextureManager>();
+		texture = previewTextures->Update(x, y, colorData);
+		stats.bytesTouched += previewTextures->lastUploadPixels * sizeof(uint16);
 	}
+	stats.Publish(true);
+	return texture;
+}
+
+UObject* ULanGenEditorUtilityWidget::SharedObject(TSubclassOf<UObject> type)
+{
+	return type ? FLanGenContext::Get().Shared(type) : nullptr;
+}
 
-create:
-	ConLog(FString::FromInt(colorData.Num()));
-	FCreateTexture2DParameters textureParam;
-	UTexture2D* texture = FImageUtils::CreateTexture2D(x, y, colorData, this, TEXT("heightTexture"), RF_NoFlags, textureParam);
+void ULanGenEditorUtilityWidget::ReleaseSharedState() { FLanGenContext::Get().Release(); }
 
-	return texture;
+FLanGenStats ULanGenEditorUtilityWidget::CombineStats(const FLanGenStats& a, const FLanGenStats& b)
+{
+	FLanGenStats res = a;
+	res.Append(b);
+	return res;
 }
 
 uint8 ULanGenEditorUtilityWidget::MapTo8Bit(float in, float min, float max) { return 255 * ((in - min) / (max - min)); }
@@ -8,6 +8,10 @@
 #include "Math/UnrealMathUtility.h"
 #include "Misc/Char.h"
 #include "Misc/DefaultValueHelper.h"
+#include "Misc/MemStack.h"
+#include "LanGenDistanceField.h"
+#include "LanGenContext.h"
+#include "Async/ParallelFor.h"
 
 void ULanGenElevationObject::ResetSeed()
 {
@@ -18,26 +22,30 @@ void ULanGenElevationObject::ResetSeed()
 
 void ULanGenElevationObject::Init(int32 in, int x, int y)
 {
+    FLanGenContext& context = FLanGenContext::Get();
+    // a size used before gets its buffers back instead of reallocating
+    context.SwapBuffer(TEXT("Elevation.Texture"), FIntPoint(lanX, lanY), FIntPoint(x, y), texture);
+    context.SwapBuffer(TEXT("Elevation.Detail"), FIntPoint(lanX, lanY), FIntPoint(x, y), detailTexture);
     lanX = x;
     lanY = y;
     seed = in;
-    p.Empty();
-    p = P_BASE;
-    randomEngine = FRandomStream(seed);
-    TArray<int> tempArray = P_BASE;
-    Shuffle(tempArray);
-    p = tempArray;
-    p.Append(tempArray);
+    random = FLanGenRandom(seed);
+    coordDraws = 0;
+    p = context.Permutation(TEXT("Elevation"), seed, [&](TArray<int>& out) {
+        TArray<int> tempArray = P_BASE;
+        Shuffle(tempArray);
+        out = tempArray;
+        out.Append(tempArray);
+    });
 }
 
 FVector2D ULanGenElevationObject::RandomizeCoord(float percentageSafeZone)
 {
     float half = (1 - percentageSafeZone) / 2;
-    int x = randomEngine.RandRange(half * lanX, (percentageSafeZone + half) * lanX),
-        y = randomEngine.RandRange(half * lanY, (percentageSafeZone + half) * lanY);
+    uint64 key = coordDraws++;
     return FVector2D(
-        randomEngine.RandRange(half * lanX, (percentageSafeZone + half) * lanX),
-        randomEngine.RandRange(half * lanY, (percentageSafeZone + half) * lanY)
+        random.RandRange(LanGenStream::Coord, key * 2, half * lanX, (percentageSafeZone + half) * lanX),
+        random.RandRange(LanGenStream::Coord, key * 2 + 1, half * lanY, (percentageSafeZone + half) * lanY)
     );
 }
 
@@ -51,61 +59,131 @@ TArray<FColor> ULanGenElevationObject::GenerateGraph(
     int disLoop, float disSmooth, int startHeight
 )
 {
-    TArray<coord> branchRootStack;
-    TArray<coord> currentLine;
-    coord* currentCoord;
+    Generate(startingPosition, rule, axiom, ruleLoop, lineLength, minAngle, maxAngle, radius, peak, skew, fillDegree, topBlend, disLoop, disSmooth, startHeight);
+    return texture;
+}
+
+void ULanGenElevationObject::Generate(
+    FVector2D startingPosition, const FString& rule, const FString& axiom,
+    int ruleLoop, int lineLength, int minAngle,
+    int maxAngle, int radius, int peak,
+    float skew, int fillDegree, float topBlend,
+    int disLoop, float disSmooth, int startHeight
+)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_GenerateGraph);
+    // every scratch container below lives on the mem stack and is released at once when this mark pops
+    FMemMark memMark(FMemStack::Get());
+    int64 arenaStart = FMemStack::Get().GetByteCount();
+    coordArray branchRoots;
+    coordStream currentLine;
+    int last;
     FString grammar;
-    bool isRandomAngle = minAngle != maxAngle;
     int peakIndex = 0;
+    uint32 strokeIndex = 0; // random key; the n-th stroke draws the same value however it is reached
+
+    stats.Reset();
+    FLanGenStageTimer totalTimer(stats.totalMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
 
     init = FColor(startHeight, 0, 0);
     texture.Init(init, lanX * lanY);
     detailTexture.Init(FColor::Black, lanX * lanY);
-
-    // L-System
-    RuleSetup(rule);
-    grammar = RuleApply(axiom, ruleLoop);
-
-    currentLine.Add(coord(startingPosition.X, startingPosition.Y, 0));
+    mainPyramid.Init(texture, lanX, lanY, init.R);
+    detailPyramid.Init(detailTexture, lanX, lanY, 0);
+    mainSeeds.Reset();
+    detailSeeds.Reset();
+    ridgePoints.Reset();
+
+    // L-System; a grammar already expanded and compiled for this seed comes from the context
+    FLanGenContext& context = FLanGenContext::Get();
+    FLanGenProgramKey programKey;
+    programKey.seed = seed;
+    programKey.ruleLoop = ruleLoop;
+    programKey.minAngle = minAngle;
+    programKey.maxAngle = maxAngle;
+    programKey.rule = rule;
+    programKey.axiom = axiom;
+    program = context.FindProgram(programKey);
+    float walkMs = 0;
+    if (!program) {
+        TSharedRef<FLanGenTurtleProgram> compiled = MakeShared<FLanGenTurtleProgram>();
+        RuleSetup(rule);
+        {
+            FLanGenStageTimer ruleTimer(stats.ruleApplyMs);
+            grammar = RuleApply(axiom, ruleLoop);
+        }
+        {
+            FLanGenStageTimer compileTimer(walkMs);
+            compiled->Compile(grammar, random, minAngle, maxAngle);
+        }
+        grammar.Empty(); // the ops carry everything the walk reads
+        context.AddProgram(programKey, compiled);
+        program = compiled;
+    }
+    stats.grammarLength = program->grammarLength;
+    stats.turtleOps = program->ops.Num();
 
     // create array of target coord
-    for (TCHAR i : grammar) {
-        currentCoord = &currentLine[currentLine.Num() - 1];
-        switch (i) {
-        case 'F': Bresenham(currentLine, lineLength); break;
-        case 'P': peakIndex = currentLine.Num() - 1; break;
-        case 'L': /*main lowest point*/
-            if (currentLine.Num() > 2) {
-                MidpointDisplacement(currentLine, peak, peakIndex, peak / 2, disLoop, disSmooth);
-                GradientSingleMain(currentLine, peak, radius, skew, fillDegree, topBlend, false);
-            }
-            break;
-        case 'D': Bresenham(currentLine, lineLength); break;
-        case 'E': /*draw detail*/
-            if (currentLine.Num() > 1) {
-                for (coord& curCoord : currentLine) curCoord.height = peak * 0.1;
-                GradientSingleMain(currentLine, currentCoord->height, 0.1 * radius, 0, 180, 0.5 * topBlend, false, true);
+    {
+        TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_Turtle);
+        SCOPE_CYCLE_COUNTER(STAT_LanGen_Turtle);
+        FLanGenStageTimer walkTimer(walkMs);
+
+        // sized once for the longest branch and the deepest nesting, the walk never grows them
+        currentLine.Reserve(program->MaxLinePoints(lineLength));
+        currentLine.Add(coord(startingPosition.X, startingPosition.Y, 0));
+        branchRoots.SetNumUninitialized(program->maxDepth);
+
+        for (uint32 i : program->ops) {
+            last = currentLine.Last();
+            switch (FLanGenTurtleProgram::Op(i)) {
+            case LanGenTurtleOp::Move: Bresenham(currentLine, lineLength, FLanGenTurtleProgram::Arg(i)); break;
+            case LanGenTurtleOp::Turn: currentLine.theta[last] = coord::Mod(currentLine.theta[last] + FLanGenTurtleProgram::Arg(i)); break;
+            case LanGenTurtleOp::Peak: peakIndex = last; break;
+            case LanGenTurtleOp::Main: /*main lowest point*/
+                if (currentLine.Num() > 2) {
+                    MidpointDisplacement(currentLine, strokeIndex++, peak, peakIndex, peak / 2, disLoop, disSmooth);
+                    GradientSingleMain(currentLine, peak, radius, skew, fillDegree, topBlend, false);
+                    for (int j = 0; j < currentLine.Num(); ++j) {
+                        coord point(currentLine.x[j], currentLine.y[j], 0);
+                        if (point.isInRange(lanX, lanY)) ridgePoints.Add(FIntPoint(point.x, point.y));
+                    }
+                }
+                break;
+            case LanGenTurtleOp::Detail: /*draw detail*/
+                if (currentLine.Num() > 1) {
+                    for (int32& height : currentLine.height) height = peak * 0.1;
+                    GradientSingleMain(currentLine, currentLine.height[last], 0.1 * radius, 0, 180, 0.5 * topBlend, false, true);
+                }
+                break;
+            case LanGenTurtleOp::Push: branchRoots[FLanGenTurtleProgram::Arg(i)] = currentLine.Get(last); break;
+            case LanGenTurtleOp::Pop: // run on line ends
+                currentLine.Reset(); // keep capacity
+                currentLine.Add(branchRoots[FLanGenTurtleProgram::Arg(i)]);
+                break;
             }
-            break;
-        case '+': currentCoord->AddTheta(isRandomAngle ? randomEngine.RandRange(minAngle, maxAngle) : minAngle); break;
-        case '-': currentCoord->AddTheta(-(isRandomAngle ? randomEngine.RandRange(minAngle, maxAngle) : minAngle)); break;
-        case '[': branchRootStack.Add(*currentCoord); break;
-        case ']': // run on line ends
-            currentLine.Empty();
-            currentLine.Add(
-                branchRootStack[branchRootStack.Num() - 1]
-            );
-            branchRootStack.RemoveAt(branchRootStack.Num() - 1);
-            break;
         }
     }
+    // exclusive times; gradient contains draw, walk contains both
+    stats.gradientMs -= stats.drawMs;
+    stats.turtleMs = walkMs - stats.midpointMs - stats.gradientMs - stats.drawMs;
+
+    if (ridgeRaster == ELanGenRidgeRaster::DistanceField) {
+        FLanGenStageTimer gradientTimer(stats.gradientMs);
+        ResolveRidgeField(mainSeeds);
+        ResolveRidgeField(detailSeeds, true);
+    }
 
     for (int i = 0; i < texture.Num(); ++i) {
         texture[i].R += detailTexture[i].R;
     }
+    mainPyramid.MarkAllWritten();
+    stats.bytesTouched += (int64)texture.Num() * sizeof(FColor) * 2;
+    stats.arenaBytes = FMemStack::Get().GetByteCount() - arenaStart;
 
-    return texture;
-
+    allocationScope.Flush();
+    stats.Publish();
 }
 
 TArray<FColor> ULanGenElevationObject::CombineTexture(TArray<FColor> texture1, TArray<FColor> texture2)
@@ -144,19 +222,24 @@ void ULanGenElevationObject::RuleSetup(FString in)
 
 FString ULanGenElevationObject::RuleApply(FString axiom, int loop)
 {
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_RuleApply);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_RuleApply);
     FString currentLstring, last;
     int lCount;
+    uint32 position;
     for (int i = 0; i < loop; ++i) {
         lCount = 0;
-        last = "";
-        currentLstring = "";
+        position = 0;
+        last.Reset();
+        currentLstring.Reset(); // reuse the buffer of the generation before last
         //check for each char in axiom
         for (TCHAR j : axiom) {
+            ++position;
             if (lCount < 2) {
                 if (j == 'L') ++lCount;
                 for (int k = 0; k < rules.Num(); ++k) {
                     if (j == rules[k].from[0]) {
-                        currentLstring.Append(RandomizeRule(k, last));
+                        RandomizeRule(k, FLanGenRandom::Key(i, position), currentLstring, last);
                         break;
                     }
                 }
@@ -164,14 +247,14 @@ FString ULanGenElevationObject::RuleApply(FString axiom, int loop)
 
                 if (lCount == 2) { // reset variable after use
                     currentLstring.Append(last);
-                    last = "";
+                    last.Reset();
                 }
             }
             else {
                 // rule check
                 for (int k = 0; k < rules.Num(); ++k) {
                     if (j == rules[k].from[0]) {
-                        currentLstring.Append(RandomizeRule(k, last));
+                        RandomizeRule(k, FLanGenRandom::Key(i, position), currentLstring, last);
                         break;
                     }
                 }
@@ -180,23 +263,22 @@ FString ULanGenElevationObject::RuleApply(FString axiom, int loop)
 
                 if (j == 'E') {
                     currentLstring.Append(last);
-                    last = "";
+                    last.Reset();
                 }
             }
         }
-        axiom = currentLstring;
+        Swap(axiom, currentLstring);
         if (axiom.Len() > 1000000000) break; // prevent editor from crashing due string length limit
     }
     return axiom;
 }
 
-void ULanGenElevationObject::Shuffle(TArray<int>& inArr) { for (int i = 0; i < inArr.Num(); ++i) inArr.Swap(i, randomEngine.RandRange(0, p.Num() - 1)); }
+void ULanGenElevationObject::Shuffle(TArray<int>& inArr) { for (int i = 0; i < inArr.Num(); ++i) inArr.Swap(i, random.RandRange(LanGenStream::Shuffle, i, 0, inArr.Num() - 1)); }
 
-FString ULanGenElevationObject::RandomizeRule(int ruleIndex, FString& last)
+void ULanGenElevationObject::RandomizeRule(int ruleIndex, uint64 key, FString& out, FString& last)
 {
-    int randomNumber = randomEngine.RandRange(1, 100);
+    int randomNumber = random.RandRange(LanGenStream::Rule, key, 1, 100);
     int currentRequirement = 0;
-    FString res;
     bool addLast = false;
     for (int i = 0; i < rules[ruleIndex].to.Num(); ++i) {
         currentRequirement += rules[ruleIndex].prob[i];
@@ -205,130 +287,150 @@ FString ULanGenElevationObject::RandomizeRule(int ruleIndex, FString& last)
                 if (j == ']') addLast = true;
 
                 if (addLast) last.AppendChar(j);
-                else res.AppendChar(j);
+                else out.AppendChar(j);
             }
-            return res;
+            return;
         }
     }
-    res = rules[ruleIndex].from;
-    return res;
+    out.Append(rules[ruleIndex].from);
 }
 
-void ULanGenElevationObject::Bresenham(TArray<coord>& currentLine, int lineLength)
+void ULanGenElevationObject::Bresenham(coordStream& currentLine, int lineLength, int steps)
 {
-    TArray<coord> res;
-    coord currentCoord = currentLine[currentLine.Num() - 1];
-
+    coord currentCoord = currentLine.Get(currentLine.Last());
+    // one heading for the whole run; each step still rounds from where the last one ended
+    float stepX = FMath::Sin(DegreeToRad(currentCoord.theta)) * lineLength;
+    float stepY = FMath::Cos(DegreeToRad(currentCoord.theta)) * lineLength;
     int x0 = currentCoord.x;
     int y0 = currentCoord.y;
-    int x = x0 + FMath::Sin(DegreeToRad(currentCoord.theta)) * lineLength;
-    int y = y0 + FMath::Cos(DegreeToRad(currentCoord.theta)) * lineLength;
-
-    int dx = FMath::Abs(x - x0);
-    int dy = FMath::Abs(y - y0);
-    int sx = (x0 < x) ? 1 : -1;
-    int sy = (y0 < y) ? 1 : -1;
-    int err = dx - dy;
-    int e2;
-
-    while (!((x0 == x) && (y0 == y))) {
-        e2 = err << 1;
-        if (e2 > -dy) {
-            err -= dy;
-            x0 += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y0 += sy;
+
+    for (int step = 0; step < steps; ++step) {
+        int x = x0 + stepX;
+        int y = y0 + stepY;
+
+        int dx = FMath::Abs(x - x0);
+        int dy = FMath::Abs(y - y0);
+        int sx = (x0 < x) ? 1 : -1;
+        int sy = (y0 < y) ? 1 : -1;
+        int err = dx - dy;
+        int e2;
+
+        while (!((x0 == x) && (y0 == y))) {
+            e2 = err << 1;
+            if (e2 > -dy) {
+                err -= dy;
+                x0 += sx;
+            }
+            if (e2 < dx) {
+                err += dx;
+                y0 += sy;
+            }
+            currentLine.Add(coord(x0, y0, currentCoord.theta));
         }
-        currentLine.Add(coord(x0, y0, currentCoord.theta));
     }
 }
 
-void ULanGenElevationObject::MidpointDisplacement(TArray<coord>& currentLineCoord, int peak, int peakIndex, int displacement, int loop, float smooth)
+void ULanGenElevationObject::MidpointDisplacement(coordStream& currentLineCoord, uint32 strokeIndex, int peak, int peakIndex, int displacement, int loop, float smooth)
 {
-    TArray<midPoint> oldIndexes, newIndexes;
-    midPoint mid;
-    int currentDisplacement = displacement,
-        randomModifier = 0;
-    float modifier = FMath::Pow(2, -smooth), linearM;
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_MidpointDisplacement);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Midpoint);
+    FLanGenStageTimer timer(stats.midpointMs);
+    FMemMark memMark(FMemStack::Get());
+    TArray<int32, TMemStackAllocator<>> signs;
+    int32* heights = currentLineCoord.height.GetData();
+    int lineEnd = currentLineCoord.Num() - 1,
+        firstLoop, secondLoop, firstCount;
+    float modifier = FMath::Pow(2, -smooth);
+
+    peakIndex = FMath::Min(peakIndex, lineEnd); // stale 'P' from a previous branch
+    // depth per half; the second half starts from the first half value and clamps on peakIndex as it always has
+    if (FMath::Pow(2, loop) > peakIndex) loop = FMath::Log2(peakIndex + 1);
+    firstLoop = loop;
+    if (FMath::Pow(2, loop) > currentLineCoord.Num() - peakIndex) loop = FMath::Log2(peakIndex + 1);
+    secondLoop = loop;
 
+    // every coin flip in one batch, keyed by stroke and midpoint in the order the level by level walk consumes them
+    firstCount = MidpointCount(peakIndex, firstLoop);
+    signs.SetNumUninitialized(firstCount + MidpointCount(lineEnd - peakIndex, secondLoop));
+    random.RandRange(LanGenStream::Displacement, FLanGenRandom::Key(strokeIndex, 0), 0, 1, signs);
+    for (int32& i : signs) i = i == 0 ? -1 : 1;
+
+    // the height stream is already a flat span, written in place
     // first half
-    if (FMath::Pow(2, loop) > peakIndex) loop = FMath::Log2(peakIndex + 1);
+    MidpointSpan(heights, midPoint(0, 0), midPoint(peakIndex, peak),
+        LinearM(peak, peakIndex + 1, 1), peakIndex, peak, firstLoop, displacement, modifier, signs.GetData());
+    // second half
+    MidpointSpan(heights, midPoint(peakIndex, peak), midPoint(lineEnd, 0),
+        LinearM(peak, lineEnd - peakIndex), peakIndex, peak, secondLoop, displacement, modifier, signs.GetData() + firstCount);
+}
 
-    oldIndexes.Add(midPoint(0, 0));
-    oldIndexes.Add(midPoint(peakIndex, peak));
+int ULanGenElevationObject::MidpointCount(int length, int loop)
+{
+    // a segment splits while it is at least 2 long; halves are floor and ceil of length / 2
+    if (loop <= 0 || length < 2) return 0;
+    return 1 + MidpointCount(length / 2, loop - 1) + MidpointCount(length - length / 2, loop - 1);
+}
 
-    // fill height between coord
-    linearM = LinearM(peak, peakIndex + 1, 1);
-    for (int j = 0; j < oldIndexes.Num() - 1; ++j)
-        for (int k = oldIndexes[j].index; k < oldIndexes[j + 1].index; ++k) currentLineCoord[k].height = Linear(linearM, k - peakIndex, peak);
-    // midpoint
+void ULanGenElevationObject::MidpointSpan(int32* heights, midPoint first, midPoint last, float linearM, int peakIndex, int peak, int loop, int displacement, float modifier, const int32* signs)
+{
+    FMemMark memMark(FMemStack::Get());
+    TArray<midPoint, TMemStackAllocator<>> oldIndexes, newIndexes;
+    midPoint mid;
+    int currentDisplacement = displacement,
+        capacity = FMath::Min((1 << FMath::Clamp(loop, 0, 30)) + 1, FMath::Max(last.index - first.index + 1, 2));
+
+    oldIndexes.Reserve(capacity);
+    newIndexes.Reserve(capacity);
+    oldIndexes.Add(first);
+    oldIndexes.Add(last);
+
+    // only the new midpoints are needed per level; a midpoint sits on the fill of the level above,
+    // which is the straight line for the first level and the lerp of its parent segment afterwards
     for (int i = 0; i < loop; ++i) {
         for (int j = 0; j < oldIndexes.Num() - 1; ++j) {
             mid.index = (int)((oldIndexes[j].index + oldIndexes[j + 1].index) / 2);
             newIndexes.Add(oldIndexes[j]);
             if (mid.index != oldIndexes[j].index) {
                 currentDisplacement *= modifier;
-                mid.height = currentLineCoord[mid.index].height + currentDisplacement * (randomEngine.RandRange(0, 1) == 0 ? -1 : 1);
+                mid.height = (i == 0)
+                    ? Linear(linearM, mid.index - peakIndex, peak)
+                    : LerpHeight(oldIndexes[j], oldIndexes[j + 1], mid.index);
+                mid.height += currentDisplacement * *signs++;
                 newIndexes.Add(mid);
             }
         }
         newIndexes.Add(oldIndexes[oldIndexes.Num() - 1]);
-        oldIndexes = newIndexes;
-        newIndexes.Empty();
-        // fill height between coord
-        for (int j = 0; j < oldIndexes.Num() - 1; ++j) {
-            for (int k = oldIndexes[j].index; k < oldIndexes[j + 1].index; ++k) {
-                currentLineCoord[k].height =
-                    (
-                        ((float)(k - oldIndexes[j].index) / (oldIndexes[j + 1].index - oldIndexes[j].index)) *
-                        (oldIndexes[j + 1].height - oldIndexes[j].height)) +
-                    oldIndexes[j].height;
-            }
-        }
+        Swap(oldIndexes, newIndexes);
+        newIndexes.Reset();
     }
 
-    // second half
-    oldIndexes.Empty();
-    newIndexes.Empty();
-    currentDisplacement = displacement;
-    if (FMath::Pow(2, loop) > currentLineCoord.Num() - peakIndex) loop = FMath::Log2(peakIndex + 1);
-    oldIndexes.Add(midPoint(peakIndex, peak));
-    oldIndexes.Add(midPoint(currentLineCoord.Num() - 1, 0));
-    // fill height between coord
-    linearM = LinearM(peak, currentLineCoord.Num() - 1 - peakIndex);
-    for (int j = 0; j < oldIndexes.Num() - 1; ++j)
-        for (int k = oldIndexes[j].index; k < oldIndexes[j + 1].index; ++k) currentLineCoord[k].height = Linear(linearM, k - peakIndex, peak);
-    // midpoint
-    for (int i = 0; i < loop; ++i) {
-        for (int j = 0; j < oldIndexes.Num() - 1; ++j) {
-            mid.index = (int)((oldIndexes[j].index + oldIndexes[j + 1].index) / 2);
-            newIndexes.Add(oldIndexes[j]);
-            if (mid.index != oldIndexes[j].index) {
-                currentDisplacement *= modifier;
-                mid.height = currentLineCoord[mid.index].height + currentDisplacement * (randomEngine.RandRange(0, 1) == 0 ? -1 : 1);
-                newIndexes.Add(mid);
-            }
-        }
-        newIndexes.Add(oldIndexes[oldIndexes.Num() - 1]);
-        oldIndexes = newIndexes;
-        newIndexes.Empty();
-        // fill height between coord
-        for (int j = 0; j < oldIndexes.Num() - 1; ++j) {
-            for (int k = oldIndexes[j].index; k < oldIndexes[j + 1].index; ++k) {
-                currentLineCoord[k].height =
-                    (
-                        ((float)(k - oldIndexes[j].index) / (oldIndexes[j + 1].index - oldIndexes[j].index)) *
-                        (oldIndexes[j + 1].height - oldIndexes[j].height)) +
-                    oldIndexes[j].height;
-            }
-        }
+    // single fill of the final level; the last index belongs to the next span
+    if (loop <= 0) {
+        for (int k = first.index; k < last.index; ++k) heights[k] = Linear(linearM, k - peakIndex, peak);
+        return;
     }
+    for (int j = 0; j < oldIndexes.Num() - 1; ++j)
+        LerpSpan(heights + oldIndexes[j].index, oldIndexes[j + 1].index - oldIndexes[j].index, oldIndexes[j].height, oldIndexes[j + 1].height);
 }
 
-void ULanGenElevationObject::GradientSingleMain(TArray<coord>& curLine, int peak, int radius, float skew, int fillDegree, float topBlend, bool calcHeight, bool isAdd)
+int ULanGenElevationObject::LerpHeight(midPoint a, midPoint b, int index)
 {
+    return (((float)(index - a.index) / (b.index - a.index)) * (b.height - a.height)) + a.height;
+}
+
+void ULanGenElevationObject::LerpSpan(int32* RESTRICT out, int length, int startHeight, int endHeight)
+{
+    // same expression as LerpHeight so every element rounds identically; no cross iteration state, vectorizes
+    int range = endHeight - startHeight;
+    for (int k = 0; k < length; ++k) out[k] = (((float)k / length) * range) + startHeight;
+}
+
+void ULanGenElevationObject::GradientSingleMain(coordStream& curLine, int peak, int radius, float skew, int fillDegree, float topBlend, bool calcHeight, bool isAdd)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_Gradient);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Gradient);
+    FLanGenStageTimer timer(stats.gradientMs);
+    ++stats.strokeCount;
     // main line height
     int mainLineRadius = curLine.Num() / 2,
         mainLineParaRadius = mainLineRadius * 0.75,
@@ -340,67 +442,255 @@ void ULanGenElevationObject::GradientSingleMain(TArray<coord>& curLine, int peak
 
     // ridgeline height
     if (calcHeight) {
+        int32* heights = curLine.height.GetData();
         for (int i = 0; i < curLine.Num(); ++i) {
             if (i - mainLineRadius < -blendOffset) {
                 // left blend
-                curLine[i].height = ExponentDecay(expA, blendHeight, i, mainLineRadius - blendOffset, -1);;
+                heights[i] = ExponentDecay(expA, blendHeight, i, mainLineRadius - blendOffset, -1);;
             }
             else if (i - mainLineRadius > blendOffset) {
                 // right blend
-                curLine[i].height = ExponentDecay(expA, blendHeight, i, mainLineRadius + blendOffset);
+                heights[i] = ExponentDecay(expA, blendHeight, i, mainLineRadius + blendOffset);
             }
             else {
-                curLine[i].height = Parabola(paraA, peak, i, mainLineRadius);
+                heights[i] = Parabola(paraA, peak, i, mainLineRadius);
             }
             // crash *memory usage* prevention
-            if (curLine[i].height < 0) curLine[i].height = 0;
+            if (heights[i] < 0) heights[i] = 0;
         }
     }
     // gradient; peak -> x; radius -> y; y = mx; m = y / x
     int eachRadius;
     float m = (float)radius / peak;
 
-    for (coord curCoord : curLine) {
-        eachRadius = m * curCoord.height;
-        GradientSingleMainHelper(curCoord, eachRadius, skew, fillDegree, topBlend, isAdd);
+    if (ridgeRaster == ELanGenRidgeRaster::Sweep) {
+        GradientSweep(curLine, m, skew, fillDegree, topBlend, isAdd);
+        return;
+    }
+    if (ridgeRaster == ELanGenRidgeRaster::DistanceField) {
+        SeedRidge(curLine, m, skew, fillDegree, topBlend, isAdd);
+        return;
+    }
+    for (int i = 0; i < curLine.Num(); ++i) {
+        eachRadius = m * curLine.height[i];
+        GradientSingleMainHelper(curLine.Get(i), eachRadius, skew, fillDegree, topBlend, isAdd);
+    }
+}
+
+falloff ULanGenElevationObject::MakeFalloff(const coord& curCoord, int radius, float skew, float topBlend)
+{
+    falloff res;
+    int topBlendOffset;
+    res.height = curCoord.height;
+    res.theta = curCoord.theta;
+    res.leftRadius = radius * ((-skew) + 1),
+        res.rightRadius = radius * (skew + 1);
+
+    res.leftA = LinearM(curCoord.height, res.leftRadius * 0.75),
+        res.blendLeftA = ExponentDecayA(curCoord.height, res.leftRadius * 0.75),
+        res.blendLeftOffset = LinearX(res.leftA, curCoord.height, curCoord.height / 4),
+        res.blendLeftHeight = (curCoord.height / 4) / res.blendLeftA;
+    res.rightA = LinearM(curCoord.height, res.rightRadius * 0.75),
+        res.blendRightA = ExponentDecayA(curCoord.height, res.rightRadius * 0.75),
+        res.blendRightOffset = LinearX(res.rightA, curCoord.height, curCoord.height / 4),
+        res.blendRightHeight = (curCoord.height / 4) / res.blendRightA;
+    res.topBlendLeftStart = topBlend * res.leftRadius,
+        res.topBlendRightStart = topBlend * res.rightRadius,
+        res.topBlendPeakOffset = Linear(res.leftA, res.topBlendLeftStart, curCoord.height),
+        res.topBlendPeak = (curCoord.height - res.topBlendPeakOffset) / 2,
+        topBlendOffset = (res.topBlendLeftStart + res.topBlendRightStart) / 2,
+        res.topBlendA = ParabolaA(res.topBlendPeak, topBlendOffset),
+        res.topBlendLeftOffset = res.topBlendLeftStart - topBlendOffset,
+        res.topBlendRightOffset = res.topBlendRightStart - topBlendOffset;
+    return res;
+}
+
+int ULanGenElevationObject::FalloffPeak(const falloff& f)
+{
+    // the splat evaluates its whole bounding box, past the radius, so a branch that rises
+    // with distance has no bound; the decaying ones peak where they start
+    if (f.leftA > 0 || f.rightA > 0 || f.blendLeftA > 1 || f.blendRightA > 1) return MAX_int32;
+    float topX = FMath::Max(f.topBlendLeftStart + Abs(f.topBlendLeftOffset), f.topBlendRightStart + Abs(f.topBlendRightOffset)),
+        peak = FMath::Max3((float)f.height, (float)f.blendLeftHeight, (float)f.blendRightHeight);
+    peak = FMath::Max(peak, f.topBlendPeak + f.topBlendPeakOffset + FMath::Max(f.topBlendA, 0.0f) * topX * topX);
+    if (!FMath::IsFinite(peak) || peak >= MAX_int32) return MAX_int32;
+    return FMath::CeilToInt(peak);
+}
+
+bool ULanGenElevationObject::FalloffHeight(const falloff& f, int x, int y, int fillDegree, int& height)
+{
+    coord rel;
+    float curEU;
+    rel.SetTheta(-(int(RadToDegree(FMath::Atan2(y, x))) - 90)); // 0 @ north
+    rel.AddTheta(-f.theta); // 0 @ center heading
+    if ((rel.theta > 270 - fillDegree && rel.theta < 270 + fillDegree) || (x == 0 && y == 0)) {
+        // left
+        curEU = EuclideanDistance(coord(x, y, 0));
+        if (curEU > FMath::Max(f.leftRadius, 1)) return false;
+        if (curEU > f.blendLeftOffset) height = ExponentDecay(f.blendLeftA, f.blendLeftHeight, curEU, f.blendLeftOffset);
+        else if (curEU < f.topBlendLeftStart) height = Parabola(f.topBlendA, f.topBlendPeak + f.topBlendPeakOffset, Abs(curEU + f.topBlendLeftOffset));
+        else height = Linear(f.leftA, curEU, f.height);
+        return true;
     }
+    if (rel.theta > 90 - fillDegree && rel.theta < 90 + fillDegree) {
+        // right
+        curEU = EuclideanDistance(coord(x, y, 0));
+        if (curEU > FMath::Max(f.rightRadius, 1)) return false;
+        if (curEU > f.blendRightOffset) height = ExponentDecay(f.blendRightA, f.blendRightHeight, curEU, f.blendRightOffset);
+        else if (curEU < f.topBlendRightStart) height = Parabola(f.topBlendA, f.topBlendPeak + f.topBlendPeakOffset, Abs(curEU + f.topBlendRightOffset));
+        else height = Linear(f.rightA, curEU, f.height);
+        return true;
+    }
+    return false;
+}
+
+void ULanGenElevationObject::GradientSweep(const coordStream& curLine, float m, float skew, int fillDegree, float topBlend, bool isAdd)
+{
+    FMemMark memMark(FMemStack::Get());
+    TArray<falloff, TMemStackAllocator<>> profiles;
+    TArray<int32, TMemStackAllocator<>> reachOf;
+    FLanGenSparseField field;
+    int reach = 1, height = 0,
+        minX = MAX_int32, minY = MAX_int32, maxX = MIN_int32, maxY = MIN_int32;
+
+    profiles.SetNumUninitialized(curLine.Num());
+    reachOf.SetNumUninitialized(curLine.Num());
+    for (int i = 0; i < curLine.Num(); ++i) {
+        profiles[i] = MakeFalloff(curLine.Get(i), m * curLine.height[i], skew, topBlend);
+        reachOf[i] = FMath::Max3(1, profiles[i].leftRadius, profiles[i].rightRadius);
+        reach = FMath::Max(reach, reachOf[i]);
+    }
+    // position streams only; plain min / max reductions
+    for (int16 i : curLine.x) minX = FMath::Min(minX, (int)i), maxX = FMath::Max(maxX, (int)i);
+    for (int16 i : curLine.y) minY = FMath::Min(minY, (int)i), maxY = FMath::Max(maxY, (int)i);
+
+    // line bounds grown by the widest footprint, clipped to the map grown by the same amount;
+    // a point further out than that is too far to cover any map pixel
+    int x0 = FMath::Max(minX - reach, -reach), x1 = FMath::Min(maxX + reach, lanX - 1 + reach),
+        y0 = FMath::Max(minY - reach, -reach), y1 = FMath::Min(maxY + reach, lanY - 1 + reach);
+    if (x0 > x1 || y0 > y1) return;
+    // whole stroke under what is already drawn; skip before the distance transform
+    FLanGenHeightPyramid& pyramid = isAdd ? detailPyramid : mainPyramid;
+    int strokePeak = MIN_int32;
+    for (const falloff& i : profiles) strokePeak = FMath::Max(strokePeak, FalloffPeak(i));
+    if (pyramid.RegionMin(x0, y0, x1, y1) >= strokePeak) {
+        ++stats.stampsRejected;
+        return;
+    }
+
+    // only the band the stroke sweeps: blocks under each point's own footprint, not the stroke's bounds
+    for (int i = 0; i < curLine.Num(); ++i) {
+        int x = curLine.x[i], y = curLine.y[i], r = reachOf[i];
+        field.AddRect(FMath::Max(x - r, x0), FMath::Max(y - r, y0), FMath::Min(x + r, x1), FMath::Min(y + r, y1));
+    }
+    field.Build();
+
+    // seed with ridge points; the taller one wins on shared pixels
+    for (int i = 0; i < curLine.Num(); ++i) {
+        int cell = field.Find(curLine.x[i], curLine.y[i]);
+        if (cell == INDEX_NONE) continue;
+        if (field.nearest[cell] == INDEX_NONE || curLine.height[i] > curLine.height[field.nearest[cell]]) field.nearest[cell] = i;
+    }
+    field.Resolve();
+    stats.bytesTouched += (int64)field.nearest.Num() * sizeof(int32) * 3;
+
+    // one falloff evaluation per band pixel on the map, against the closest ridge point
+    for (int slot = 0; slot < field.blocks.Num(); ++slot) {
+        int bx = field.blocks[slot].X * FLanGenSparseField::BLOCK, by = field.blocks[slot].Y * FLanGenSparseField::BLOCK;
+        for (int x = FMath::Max(bx, 0); x < FMath::Min(bx + FLanGenSparseField::BLOCK, lanX); ++x) {
+            for (int y = FMath::Max(by, 0); y < FMath::Min(by + FLanGenSparseField::BLOCK, lanY); ++y) {
+                int ridge = field.nearest[slot * FLanGenSparseField::AREA + (x - bx) * FLanGenSparseField::BLOCK + (y - by)];
+                if (ridge == INDEX_NONE) continue;
+                // outside the point's reach FalloffHeight rejects anyway; skip its atan2 / sqrt
+                int dx = x - curLine.x[ridge], dy = y - curLine.y[ridge];
+                if (dx * dx + dy * dy > reachOf[ridge] * reachOf[ridge] || pyramid.IsOccluded(x, y, strokePeak)) continue;
+                ++stats.pixelsRasterized;
+                if (FalloffHeight(profiles[ridge], dx, dy, fillDegree, height))
+                    DrawPixel(x * lanY + y, height, isAdd);
+            }
+        }
+    }
+}
+
+void ULanGenElevationObject::SeedRidge(const coordStream& curLine, float m, float skew, int fillDegree, float topBlend, bool isAdd)
+{
+    TArray<ridgeSeed>& seeds = isAdd ? detailSeeds : mainSeeds;
+    ridgeSeed point;
+    point.fillDegree = fillDegree;
+    for (int i = 0; i < curLine.Num(); ++i) {
+        point.x = curLine.x[i];
+        point.y = curLine.y[i];
+        point.profile = MakeFalloff(curLine.Get(i), m * curLine.height[i], skew, topBlend);
+        seeds.Add(point);
+    }
+}
+
+void ULanGenElevationObject::ResolveRidgeField(TArray<ridgeSeed>& seeds, bool isAdd)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_ResolveRidgeField);
+    if (seeds.Num() == 0) return;
+    FMemMark memMark(FMemStack::Get());
+    TArray<int32, TMemStackAllocator<>> nearest, seedOf, radius;
+    int reach = 1;
+    for (const ridgeSeed& i : seeds) reach = FMath::Max3(reach, i.profile.leftRadius, i.profile.rightRadius);
+
+    // map grown by the widest footprint; seeds further out can't cover a map pixel
+    int gridX = lanX + 2 * reach, gridY = lanY + 2 * reach;
+    nearest.Init(INDEX_NONE, gridX * gridY);
+    seedOf.SetNumUninitialized(gridX * gridY);
+    radius.SetNumUninitialized(gridX * gridY);
+    for (int i = 0; i < seeds.Num(); ++i) {
+        coord gridCoord(seeds[i].x + reach, seeds[i].y + reach, 0);
+        if (!gridCoord.isInRange(gridX, gridY)) continue;
+        int gridIndex = gridCoord.index(gridY);
+        // overlapping ridges; the taller one owns the pixel
+        if (nearest[gridIndex] == INDEX_NONE || seeds[i].profile.height > seeds[seedOf[gridIndex]].profile.height) {
+            nearest[gridIndex] = gridIndex;
+            seedOf[gridIndex] = i;
+            radius[gridIndex] = FMath::Max3(1, seeds[i].profile.leftRadius, seeds[i].profile.rightRadius);
+        }
+    }
+    // weighted by footprint, so a small ridge close by doesn't take the flank of a tall one further out,
+    // and a pixel any ridge reaches goes to a ridge that reaches it instead of staying at init
+    FLanGenDistanceField::NearestPowerSeed(nearest, radius, gridX, gridY, true);
+
+    // every map pixel is owned by exactly one task, so no write is shared
+    int64 written = 0;
+    ParallelFor(lanX, [&](int32 x) {
+        int height = 0, rowWritten = 0;
+        for (int y = 0; y < lanY; ++y) {
+            int closest = nearest[(x + reach) * gridY + y + reach];
+            if (closest == INDEX_NONE) continue;
+            const ridgeSeed& ridge = seeds[seedOf[closest]];
+            if (!FalloffHeight(ridge.profile, x - ridge.x, y - ridge.y, ridge.fillDegree, height)) continue;
+            FColor& pixel = isAdd ? detailTexture[x * lanY + y] : texture[x * lanY + y];
+            int current = isAdd ? pixel.R : pixel.R - init.R;
+            if (height > current) {
+                pixel.R = isAdd ? height : height + init.R;
+                ++rowWritten;
+            }
+        }
+        FPlatformAtomics::InterlockedAdd(&written, (int64)rowWritten);
+    });
+    (isAdd ? detailPyramid : mainPyramid).MarkAllWritten();
+    stats.pixelsRasterized += (int64)lanX * lanY;
+    stats.pixelsWritten += written;
+    stats.bytesTouched += (int64)gridX * gridY * sizeof(int32) * 4 + seeds.Num() * sizeof(ridgeSeed);
 }
 
 void ULanGenElevationObject::GradientSingleMainHelper(coord curCoord, int radius, float skew, int fillDegree, float topBlend, bool isAdd)
 {
-    int leftRadius = radius * ((-skew) + 1),
-        rightRadius = radius * (skew + 1),
+    falloff f = MakeFalloff(curCoord, radius, skew, topBlend);
+    int leftRadius = f.leftRadius,
+        rightRadius = f.rightRadius,
         curIndex = 0, tempTheta = 0,
-        blendLeftHeight = 0, blendRightHeight = 0,
-        blendLeftOffset = 0, blendRightOffset = 0,
-        leftFunc = 0, rightFunc = 0,
-        topBlendLeftStart = 0, topBlendRightStart = 0,
-        topBlendPeakOffset = 0, topBlendPeak = 0,
-        topBlendOffset = 0, topBlendLeftOffset = 0, topBlendRightOffset = 0,
         xIt, yIt;
-    float blendLeftA = 0, blendRightA = 0, curEU = 0, topBlendA = 0,
-        leftA, rightA;
+    float curEU = 0;
     coord startFill = coord(), endFill = coord(),
         a = coord(), b = coord(), c = coord(), d = coord();
 
-    leftA = LinearM(curCoord.height, leftRadius * 0.75),
-        blendLeftA = ExponentDecayA(curCoord.height, leftRadius * 0.75),
-        blendLeftOffset = LinearX(leftA, curCoord.height, curCoord.height / 4),
-        blendLeftHeight = (curCoord.height / 4) / blendLeftA;
-    rightA = LinearM(curCoord.height, rightRadius * 0.75),
-        blendRightA = ExponentDecayA(curCoord.height, rightRadius * 0.75),
-        blendRightOffset = LinearX(rightA, curCoord.height, curCoord.height / 4),
-        blendRightHeight = (curCoord.height / 4) / blendRightA;
-    topBlendLeftStart = topBlend * leftRadius,
-        topBlendRightStart = topBlend * rightRadius,
-        topBlendPeakOffset = Linear(leftA, topBlendLeftStart, curCoord.height),
-        topBlendPeak = (curCoord.height - topBlendPeakOffset) / 2,
-        topBlendOffset = (topBlendLeftStart + topBlendRightStart) / 2,
-        topBlendA = ParabolaA(topBlendPeak, topBlendOffset),
-        topBlendLeftOffset = topBlendLeftStart - topBlendOffset,
-        topBlendRightOffset = topBlendRightStart - topBlendOffset;
-
-    TArray<coord> grad;
+    FMemMark memMark(FMemStack::Get());
+    coordArray grad;
 
     // figuring out where to start loop;
     a.x =
@@ -437,10 +727,24 @@ void ULanGenElevationObject::GradientSingleMainHelper(coord curCoord, int radius
     xIt = (endFill.x > startFill.x) ? 1 : -1;
     yIt = (endFill.y > startFill.y) ? 1 : -1;
 
+    // footprint already covered by taller terrain
+    FLanGenHeightPyramid& pyramid = isAdd ? detailPyramid : mainPyramid;
+    int peak = FalloffPeak(f);
+    if (pyramid.RegionMin(
+        curCoord.x + FMath::Min(startFill.x, endFill.x), curCoord.y + FMath::Min(startFill.y, endFill.y),
+        curCoord.x + FMath::Max(startFill.x, endFill.x), curCoord.y + FMath::Max(startFill.y, endFill.y)) >= peak) {
+        ++stats.stampsRejected;
+        return;
+    }
+
     grad.Init(coord(), Abs((endFill.x - startFill.x + xIt) * (endFill.y - startFill.y + yIt)));
+    stats.bytesTouched += (int64)grad.Num() * sizeof(coord);
 
     for (int x = startFill.x; (xIt == 1) ? x <= endFill.x : x >= endFill.x; x += xIt) {
         for (int y = startFill.y; (yIt == 1) ? y <= endFill.y : y >= endFill.y; y += yIt) {
+            // left as an empty coord, which never draws
+            if (pyramid.IsOccluded(x + curCoord.x, y + curCoord.y, peak)) continue;
+            ++stats.pixelsRasterized;
             curIndex = Abs((x - startFill.x) * (endFill.y - startFill.y)) + Abs(y - startFill.y);
             // fill in x degree left and right only
             tempTheta = RadToDegree(FMath::Atan2(y, x));
@@ -453,9 +757,9 @@ void ULanGenElevationObject::GradientSingleMainHelper(coord curCoord, int radius
                 grad[curIndex].x = x + curCoord.x;
                 grad[curIndex].y = y + curCoord.y;
 
-                if (curEU > blendLeftOffset) grad[curIndex].height = ExponentDecay(blendLeftA, blendLeftHeight, curEU, blendLeftOffset);
-                else if (curEU < topBlendLeftStart) grad[curIndex].height = Parabola(topBlendA, topBlendPeak + topBlendPeakOffset, Abs(curEU + topBlendLeftOffset));
-                else grad[curIndex].height = Linear(leftA, curEU, curCoord.height);
+                if (curEU > f.blendLeftOffset) grad[curIndex].height = ExponentDecay(f.blendLeftA, f.blendLeftHeight, curEU, f.blendLeftOffset);
+                else if (curEU < f.topBlendLeftStart) grad[curIndex].height = Parabola(f.topBlendA, f.topBlendPeak + f.topBlendPeakOffset, Abs(curEU + f.topBlendLeftOffset));
+                else grad[curIndex].height = Linear(f.leftA, curEU, curCoord.height);
             }
             else if (grad[curIndex].theta > 90 - fillDegree && grad[curIndex].theta < 90 + fillDegree) {
                 curEU = EuclideanDistance(coord(x, y, 0)); // calculate if condition match only; optimization
@@ -463,9 +767,9 @@ void ULanGenElevationObject::GradientSingleMainHelper(coord curCoord, int radius
                 grad[curIndex].x = x + curCoord.x;
                 grad[curIndex].y = y + curCoord.y;
 
-                if (curEU > blendRightOffset) grad[curIndex].height += ExponentDecay(blendRightA, blendRightHeight, curEU, blendRightOffset);
-                else if (curEU < topBlendRightStart) grad[curIndex].height += Parabola(topBlendA, topBlendPeak + topBlendPeakOffset, Abs(curEU + topBlendRightOffset));
-                else grad[curIndex].height += Linear(rightA, curEU, curCoord.height);
+                if (curEU > f.blendRightOffset) grad[curIndex].height += ExponentDecay(f.blendRightA, f.blendRightHeight, curEU, f.blendRightOffset);
+                else if (curEU < f.topBlendRightStart) grad[curIndex].height += Parabola(f.topBlendA, f.topBlendPeak + f.topBlendPeakOffset, Abs(curEU + f.topBlendRightOffset));
+                else grad[curIndex].height += Linear(f.rightA, curEU, curCoord.height);
             }
         }
     }
@@ -511,24 +815,57 @@ float ULanGenElevationObject::LinearM(float c, float xMax, float modifier) { ret
 
 float ULanGenElevationObject::LinearX(float m, float c, float y) { return (y - c) / m; }
 
-void ULanGenElevationObject::Draw(TArray<coord> currentLine, bool overwrite)
+void ULanGenElevationObject::Draw(TArrayView<const coord> currentLine, bool overwrite)
 {
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Draw);
+    FLanGenStageTimer timer(stats.drawMs);
+    stats.bytesTouched += (int64)currentLine.Num() * sizeof(coord);
     /*0 = do not overwerite; 1 = overwrite; 2 = add value*/
-    for (coord i : currentLine) {
+    for (const coord& i : currentLine) {
         if (i.isInRange(lanX, lanY)) {
+            stats.bytesTouched += sizeof(FColor);
             /*only draw if current height higher*/
-            if (i.height > texture[i.index(lanY)].R - init.R || overwrite) texture[i.index(lanY)].R = i.height + init.R;
+            if (i.height > texture[i.index(lanY)].R - init.R || overwrite) {
+                texture[i.index(lanY)].R = i.height + init.R;
+                ++stats.pixelsWritten;
+                mainPyramid.MarkWritten(i.x, i.y);
+            }
         }
     }
 }
 
-void ULanGenElevationObject::DrawDetail(TArray<coord> currentLine, bool overwrite)
+void ULanGenElevationObject::DrawPixel(int index, int height, bool isAdd)
 {
+    /*only draw if current height higher*/
+    if (isAdd) {
+        if (height > detailTexture[index].R) {
+            detailTexture[index].R = height;
+            detailPyramid.MarkWritten(index / lanY, index % lanY);
+            ++stats.pixelsWritten;
+        }
+    }
+    else if (height > texture[index].R - init.R) {
+        texture[index].R = height + init.R;
+        mainPyramid.MarkWritten(index / lanY, index % lanY);
+        ++stats.pixelsWritten;
+    }
+}
+
+void ULanGenElevationObject::DrawDetail(TArrayView<const coord> currentLine, bool overwrite)
+{
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Draw);
+    FLanGenStageTimer timer(stats.drawMs);
+    stats.bytesTouched += (int64)currentLine.Num() * sizeof(coord);
     /*0 = do not overwerite; 1 = overwrite; 2 = add value*/
-    for (coord i : currentLine) {
+    for (const coord& i : currentLine) {
         if (i.isInRange(lanX, lanY)) {
+            stats.bytesTouched += sizeof(FColor);
             /*only draw if current height higher*/
-            if (i.height > detailTexture[i.index(lanY)].R || overwrite) detailTexture[i.index(lanY)].R = i.height;
+            if (i.height > detailTexture[i.index(lanY)].R || overwrite) {
+                detailTexture[i.index(lanY)].R = i.height;
+                ++stats.pixelsWritten;
+                detailPyramid.MarkWritten(i.x, i.y);
+            }
         }
     }
 }
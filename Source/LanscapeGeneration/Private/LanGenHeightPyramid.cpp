@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenHeightPyramid.h"
+
+void FLanGenHeightPyramid::Init(const TArray<FColor>& inSource, int x, int y, int inBias)
+{
+    source = &inSource;
+    lanX = x;
+    lanY = y;
+    bias = inBias;
+    blocksX = FMath::DivideAndRoundUp(x, BLOCK);
+    blocksY = FMath::DivideAndRoundUp(y, BLOCK);
+    superX = FMath::DivideAndRoundUp(blocksX, FAN);
+    superY = FMath::DivideAndRoundUp(blocksY, FAN);
+    blockMin.SetNumUninitialized(blocksX * blocksY);
+    superMin.SetNumUninitialized(superX * superY);
+    blockDirty.SetNumUninitialized(blocksX * blocksY);
+    superDirty.SetNumUninitialized(superX * superY);
+    MarkAllWritten();
+}
+
+void FLanGenHeightPyramid::MarkAllWritten()
+{
+    FMemory::Memset(blockDirty.GetData(), 1, blockDirty.Num());
+    FMemory::Memset(superDirty.GetData(), 1, superDirty.Num());
+}
+
+int FLanGenHeightPyramid::RegionMin(int x0, int y0, int x1, int y1)
+{
+    x0 = FMath::Max(x0, 0), y0 = FMath::Max(y0, 0);
+    x1 = FMath::Min(x1, lanX - 1), y1 = FMath::Min(y1, lanY - 1);
+    if (x0 > x1 || y0 > y1) return MAX_int32;
+
+    // whole super blocks where the rect covers them, their blocks along the edges
+    int res = MAX_int32,
+        bx0 = x0 / BLOCK, by0 = y0 / BLOCK, bx1 = x1 / BLOCK, by1 = y1 / BLOCK;
+    for (int sx = bx0 / FAN; sx <= bx1 / FAN; ++sx) {
+        for (int sy = by0 / FAN; sy <= by1 / FAN; ++sy) {
+            int cx0 = sx * FAN, cy0 = sy * FAN,
+                cx1 = FMath::Min(cx0 + FAN, blocksX) - 1, cy1 = FMath::Min(cy0 + FAN, blocksY) - 1;
+            if (cx0 >= bx0 && cx1 <= bx1 && cy0 >= by0 && cy1 <= by1) {
+                res = FMath::Min(res, SuperMin(sx, sy));
+                continue;
+            }
+            for (int bx = FMath::Max(cx0, bx0); bx <= FMath::Min(cx1, bx1); ++bx)
+                for (int by = FMath::Max(cy0, by0); by <= FMath::Min(cy1, by1); ++by)
+                    res = FMath::Min(res, BlockMin(bx, by));
+        }
+    }
+    return res;
+}
+
+int FLanGenHeightPyramid::BlockMin(int bx, int by)
+{
+    int block = bx * blocksY + by;
+    if (blockDirty[block]) {
+        const FColor* data = source->GetData();
+        int res = MAX_int32;
+        for (int x = bx * BLOCK; x < FMath::Min((bx + 1) * BLOCK, lanX); ++x)
+            for (int y = by * BLOCK; y < FMath::Min((by + 1) * BLOCK, lanY); ++y)
+                res = FMath::Min(res, data[x * lanY + y].R - bias);
+        blockMin[block] = res;
+        blockDirty[block] = 0;
+    }
+    return blockMin[block];
+}
+
+int FLanGenHeightPyramid::SuperMin(int sx, int sy)
+{
+    int super = sx * superY + sy;
+    if (superDirty[super]) {
+        int res = MAX_int32;
+        for (int bx = sx * FAN; bx < FMath::Min((sx + 1) * FAN, blocksX); ++bx)
+            for (int by = sy * FAN; by < FMath::Min((sy + 1) * FAN, blocksY); ++by)
+                res = FMath::Min(res, BlockMin(bx, by));
+        superMin[super] = res;
+        superDirty[super] = 0;
+    }
+    return superMin[super];
+}
@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenHeightfieldFile.h"
+#include "HAL/FileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/MemStack.h"
+#include "Async/ParallelFor.h"
+
+bool ULanGenHeightfieldFile::WriteHeightmap(const FString& path, const TArray<FColor>& heightmap, int x, int y)
+{
+    if (heightmap.Num() != x * y) return false;
+    return WriteTiles(path, x, y, true, [&](int32 i) { return (float)heightmap[i].R; });
+}
+
+bool ULanGenHeightfieldFile::WriteHeights(const FString& path, const TArray<float>& heights, int x, int y)
+{
+    if (heights.Num() != x * y) return false;
+    return WriteTiles(path, x, y, false, [&](int32 i) { return heights[i]; });
+}
+
+template <typename Func>
+bool ULanGenHeightfieldFile::WriteTiles(const FString& path, int x, int y, bool exact, Func sample)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_HeightfieldWrite);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Heightfield);
+    stats.Reset();
+    FLanGenStageTimer timer(stats.totalMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
+    if (x <= 0 || y <= 0) return false;
+    TUniquePtr<FArchive> writer(IFileManager::Get().CreateFileWriter(*path));
+    if (!writer) return false;
+
+    int outTilesX = FMath::DivideAndRoundUp(x, TILE), outTilesY = FMath::DivideAndRoundUp(y, TILE);
+    fileHeader head = { MAGIC, VERSION, x, y, TILE, 0 };
+    TArray<tileEntry> entries;
+    TArray<TArray<uint8>> packed;
+    entries.SetNumZeroed(outTilesX * outTilesY);
+    packed.SetNum(BATCH);
+
+    // the index is written once the blob offsets are known
+    writer->Serialize(&head, sizeof(head));
+    writer->Serialize(entries.GetData(), entries.Num() * sizeof(tileEntry));
+    uint64 offset = writer->Tell();
+
+    for (int first = 0; first < entries.Num(); first += BATCH) {
+        int count = FMath::Min(BATCH, entries.Num() - first);
+        ParallelFor(count, [&](int32 i) {
+            int32 tile = first + i;
+            int x0 = tile / outTilesY * TILE, y0 = tile % outTilesY * TILE,
+                w = FMath::Min(TILE, x - x0), h = FMath::Min(TILE, y - y0);
+            FMemMark memMark(FMemStack::Get());
+            TArray<float, TMemStackAllocator<>> values;
+            TArray<uint16, TMemStackAllocator<>> q;
+            values.SetNumUninitialized(w * h);
+            q.SetNumUninitialized(w * h);
+            float low = MAX_flt, high = -MAX_flt;
+            for (int px = 0; px < w; ++px) {
+                for (int py = 0; py < h; ++py) {
+                    float value = sample((x0 + px) * y + y0 + py);
+                    values[px * h + py] = value;
+                    low = FMath::Min(low, value), high = FMath::Max(high, value);
+                }
+            }
+
+            // exact input is integral, a step of 1 keeps it lossless
+            tileEntry& entry = entries[tile];
+            entry.base = low;
+            entry.step = exact ? 1 : precision;
+            if (entry.step <= 0 || (high - low) / entry.step > MAX_uint16) entry.step = high > low ? (high - low) / MAX_uint16 : 1;
+            for (int j = 0; j < w * h; ++j)
+                q[j] = FMath::Clamp(FMath::RoundToInt((values[j] - low) / entry.step), 0, (int)MAX_uint16);
+            EncodeTile(q.GetData(), w, h, codec, packed[i], entry.codec);
+        });
+        for (int i = 0; i < count; ++i) {
+            entries[first + i].offset = offset;
+            entries[first + i].packedSize = packed[i].Num();
+            writer->Serialize(packed[i].GetData(), packed[i].Num());
+            offset += packed[i].Num();
+        }
+    }
+    writer->Seek(sizeof(head));
+    writer->Serialize(entries.GetData(), entries.Num() * sizeof(tileEntry));
+
+    bool isOk = !writer->IsError();
+    isOk &= writer->Close();
+    lastFileBytes = offset;
+    stats.bytesTouched = (int64)x * y * sizeof(float) + offset;
+    return isOk;
+}
+
+bool ULanGenHeightfieldFile::Open(const FString& path)
+{
+    Close();
+    reader.Reset(IFileManager::Get().CreateFileReader(*path));
+    if (!reader) return false;
+
+    fileHeader head;
+    readerSize = reader->TotalSize();
+    if (readerSize < (int64)sizeof(head)) {
+        Close();
+        return false;
+    }
+    reader->Serialize(&head, sizeof(head));
+    if (head.magic != MAGIC || head.version != VERSION || head.sizeX <= 0 || head.sizeY <= 0 || head.tile != TILE
+        || (int64)head.sizeX * head.sizeY > MAX_int32) {
+        Close();
+        return false;
+    }
+    tileSize = head.tile;
+    tilesX = FMath::DivideAndRoundUp(head.sizeX, tileSize);
+    tilesY = FMath::DivideAndRoundUp(head.sizeY, tileSize);
+    if ((int64)tilesX * tilesY * sizeof(tileEntry) > readerSize - (int64)sizeof(head)) {
+        Close();
+        return false;
+    }
+    index.SetNumUninitialized(tilesX * tilesY);
+    reader->Serialize(index.GetData(), index.Num() * sizeof(tileEntry));
+
+    // a truncated or foreign file fails here instead of in the middle of a decode
+    bool isOk = !reader->IsError();
+    for (const tileEntry& i : index)
+        // no offset + size, a huge offset would wrap past the check
+        isOk &= i.codec <= (uint8)ELanGenHeightCodec::Oodle && i.offset <= (uint64)readerSize && i.packedSize <= (uint64)readerSize - i.offset;
+    if (!isOk) {
+        Close();
+        return false;
+    }
+    lanX = head.sizeX;
+    lanY = head.sizeY;
+    return true;
+}
+
+void ULanGenHeightfieldFile::Close()
+{
+    reader.Reset();
+    readerSize = 0;
+    lanX = lanY = tilesX = tilesY = 0;
+    index.Empty();
+}
+
+TArray<float> ULanGenHeightfieldFile::ReadRegion(int x0, int y0, int x, int y)
+{
+    TArray<float> res;
+    if (!IsOpen() || x <= 0 || y <= 0 || x0 < 0 || y0 < 0 || x0 + x > lanX || y0 + y > lanY) return res;
+    res.SetNumUninitialized(x * y);
+    if (!ReadTiles(x0, y0, x0 + x, y0 + y, [&](int px, int py, float height) { res[(px - x0) * y + py - y0] = height; })) res.Empty();
+    return res;
+}
+
+TArray<FColor> ULanGenHeightfieldFile::ReadHeightmap()
+{
+    TArray<FColor> res;
+    if (!IsOpen()) return res;
+    res.SetNumUninitialized(lanX * lanY);
+    if (!ReadTiles(0, 0, lanX, lanY, [&](int px, int py, float height) {
+        res[px * lanY + py] = FColor(FMath::Clamp(FMath::RoundToInt(height), 0, 255), 0, 0);
+    })) res.Empty();
+    return res;
+}
+
+template <typename Func>
+bool ULanGenHeightfieldFile::ReadTiles(int x0, int y0, int x1, int y1, Func store)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_HeightfieldRead);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Heightfield);
+    stats.Reset();
+    FLanGenStageTimer timer(stats.totalMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
+    TArray<int32> tiles;
+    TArray<int64> at;
+    TArray<uint8> blobs;
+    int32 failed = 0;
+
+    // tile order is file order, so each batch is one forward pass over the file
+    for (int tx = x0 / tileSize; tx <= (x1 - 1) / tileSize; ++tx)
+        for (int ty = y0 / tileSize; ty <= (y1 - 1) / tileSize; ++ty)
+            tiles.Add(tx * tilesY + ty);
+
+    for (int first = 0; first < tiles.Num(); first += BATCH) {
+        int count = FMath::Min(BATCH, tiles.Num() - first);
+        // reads stay on this thread, only the decode fans out
+        at.SetNum(count + 1);
+        at[0] = 0;
+        for (int i = 0; i < count; ++i) at[i + 1] = at[i] + index[tiles[first + i]].packedSize;
+        blobs.SetNumUninitialized(at[count], false);
+        for (int i = 0; i < count; ++i) {
+            reader->Seek(index[tiles[first + i]].offset);
+            reader->Serialize(blobs.GetData() + at[i], at[i + 1] - at[i]);
+        }
+        if (reader->IsError()) return false;
+        stats.bytesTouched += at[count];
+
+        ParallelFor(count, [&](int32 i) {
+            int32 tile = tiles[first + i];
+            const tileEntry& entry = index[tile];
+            int tx0 = tile / tilesY * tileSize, ty0 = tile % tilesY * tileSize,
+                w = FMath::Min(tileSize, lanX - tx0), h = FMath::Min(tileSize, lanY - ty0);
+            FMemMark memMark(FMemStack::Get());
+            TArray<uint16, TMemStackAllocator<>> q;
+            q.SetNumUninitialized(w * h);
+            if (!DecodeTile(blobs.GetData() + at[i], entry.packedSize, entry.codec, w, h, q.GetData())) {
+                FPlatformAtomics::InterlockedExchange(&failed, 1);
+                return;
+            }
+            for (int x = FMath::Max(x0, tx0); x < FMath::Min(x1, tx0 + w); ++x)
+                for (int y = FMath::Max(y0, ty0); y < FMath::Min(y1, ty0 + h); ++y)
+                    store(x, y, entry.base + q[(x - tx0) * h + y - ty0] * entry.step);
+        });
+        if (failed) return false;
+    }
+    stats.bytesTouched += (int64)(x1 - x0) * (y1 - y0) * sizeof(float);
+    return true;
+}
+
+void ULanGenHeightfieldFile::EncodeTile(const uint16* q, int w, int h, ELanGenHeightCodec inCodec, TArray<uint8>& out, uint8& outCodec)
+{
+    FMemMark memMark(FMemStack::Get());
+    TArray<uint8, TMemStackAllocator<>> planes;
+    int32 num = w * h, rawSize = num * 2;
+    planes.SetNumUninitialized(rawSize);
+
+    // zigzagged residuals split in a low and a high byte plane; smooth terrain leaves the high plane near empty
+    uint8* low = planes.GetData();
+    uint8* high = low + num;
+    for (int x = 0; x < w; ++x) {
+        for (int y = 0; y < h; ++y) {
+            int32 i = x * h + y;
+            int16 residual = (int16)(uint16)(q[i] - Predict(q, x, y, h));
+            uint16 zigzag = (uint16)((residual << 1) ^ (residual >> 15));
+            low[i] = zigzag & 0xff;
+            high[i] = zigzag >> 8;
+        }
+    }
+
+    if (inCodec != ELanGenHeightCodec::Raw) {
+        FName format = FormatName((uint8)inCodec);
+        int32 packedSize = FCompression::CompressMemoryBound(format, rawSize);
+        out.SetNumUninitialized(packedSize, false);
+        if (FCompression::CompressMemory(format, out.GetData(), packedSize, planes.GetData(), rawSize) && packedSize < rawSize) {
+            out.SetNum(packedSize, false);
+            outCodec = (uint8)inCodec;
+            return;
+        }
+    }
+    // incompressible, or the codec is not in this build
+    out.SetNumUninitialized(rawSize, false);
+    FMemory::Memcpy(out.GetData(), planes.GetData(), rawSize);
+    outCodec = (uint8)ELanGenHeightCodec::Raw;
+}
+
+bool ULanGenHeightfieldFile::DecodeTile(const uint8* in, int32 size, uint8 inCodec, int w, int h, uint16* q)
+{
+    FMemMark memMark(FMemStack::Get());
+    TArray<uint8, TMemStackAllocator<>> planes;
+    int32 num = w * h, rawSize = num * 2;
+    const uint8* low = in;
+    if (inCodec == (uint8)ELanGenHeightCodec::Raw) {
+        if (size != rawSize) return false;
+    }
+    else {
+        planes.SetNumUninitialized(rawSize);
+        if (!FCompression::UncompressMemory(FormatName(inCodec), planes.GetData(), rawSize, in, size)) return false;
+        low = planes.GetData();
+    }
+
+    const uint8* high = low + num;
+    for (int x = 0; x < w; ++x) {
+        for (int y = 0; y < h; ++y) {
+            int32 i = x * h + y;
+            uint16 zigzag = low[i] | high[i] << 8;
+            int16 residual = (int16)((zigzag >> 1) ^ -(zigzag & 1));
+            q[i] = (uint16)(Predict(q, x, y, h) + residual);
+        }
+    }
+    return true;
+}
+
+uint16 ULanGenHeightfieldFile::Predict(const uint16* q, int x, int y, int h)
+{
+    if (x == 0) return y == 0 ? 0 : q[y - 1];
+    if (y == 0) return q[(x - 1) * h];
+    int left = q[x * h + y - 1], up = q[(x - 1) * h + y], corner = q[(x - 1) * h + y - 1];
+    if (corner >= FMath::Max(left, up)) return FMath::Min(left, up);
+    if (corner <= FMath::Min(left, up)) return FMath::Max(left, up);
+    return left + up - corner;
+}
+
+FName ULanGenHeightfieldFile::FormatName(uint8 inCodec)
+{
+    switch ((ELanGenHeightCodec)inCodec) {
+    case ELanGenHeightCodec::LZ4: return NAME_LZ4;
+    case ELanGenHeightCodec::Oodle: return FName(TEXT("Oodle"));
+    default: return NAME_None;
+    }
+}
@@ -0,0 +1,550 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenHydrologyObject.h"
+#include "Misc/MemStack.h"
+#include "Async/ParallelFor.h"
+
+/* directions in turning order so the opposite of d is d + 4; even = cardinal */
+static const int DX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int DY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const float DIST[8] = { 1, UE_SQRT_2, 1, UE_SQRT_2, 1, UE_SQRT_2, 1, UE_SQRT_2 };
+
+template <typename Func>
+void ULanGenHydrologyObject::ForTile(int32 tile, Func func) const
+{
+    int tx = tile / tilesY, ty = tile % tilesY;
+    for (int x = tx * TILE; x < FMath::Min(lanX, (tx + 1) * TILE); ++x)
+        for (int y = ty * TILE; y < FMath::Min(lanY, (ty + 1) * TILE); ++y)
+            func(x, y, x * lanY + y);
+}
+
+bool ULanGenHydrologyObject::Run(const TArray<FColor>& heightmap, int x, int y)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_Hydrology);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Hydrology);
+    stats.Reset();
+    FLanGenStageTimer timer(stats.totalMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
+    if (x <= 0 || y <= 0 || heightmap.Num() != x * y) return false;
+
+    uint32 carveKey = HashCombine(HashCombine(GetTypeHash((uint32)fillDepressions), GetTypeHash(riverThreshold)),
+        HashCombine(GetTypeHash(carveScale), GetTypeHash(maxCarveDepth)));
+    bool full = !isValid || x != lanX || y != lanY || routing != routedWith;
+    if (full) {
+        lanX = x;
+        lanY = y;
+        tilesX = FMath::DivideAndRoundUp(x, TILE);
+        tilesY = FMath::DivideAndRoundUp(y, TILE);
+        height.SetNumUninitialized(x * y);
+        localFilled.SetNumUninitialized(x * y);
+        filled.SetNumUninitialized(x * y);
+        label.SetNumUninitialized(x * y);
+        receiver.SetNumUninitialized(x * y);
+        receiver2.SetNumUninitialized(x * y);
+        share.SetNumUninitialized(x * y);
+        accumulation.SetNumUninitialized(x * y);
+        donorCount.SetNumUninitialized(x * y);
+        accDirty.SetNumUninitialized(x * y);
+        tileSeeds.SetNum(tilesX * tilesY);
+        tileFlats.SetNum(tilesX * tilesY);
+        tileEdges.SetNum(tilesX * tilesY);
+        labelBase.SetNumUninitialized(tilesX * tilesY);
+        labelCount = 0;
+        for (int32 tile = 0; tile < tilesX * tilesY; ++tile) {
+            int width = FMath::Min(TILE, y - tile % tilesY * TILE), length = FMath::Min(TILE, x - tile / tilesY * TILE);
+            labelBase[tile] = labelCount;
+            labelCount += (width <= 2 || length <= 2) ? width * length : 2 * width + 2 * length - 4;
+        }
+        spill.SetNumUninitialized(labelCount);
+        carved = heightmap;
+    }
+    for (TArray<uint8>* flags : { &inputTiles, &fillTiles, &routeTiles, &accTiles }) {
+        flags->SetNumUninitialized(tilesX * tilesY);
+        FMemory::Memset(flags->GetData(), full ? 1 : 0, flags->Num());
+    }
+
+    // compare against the last input; nothing downstream of a clean tile needs to run
+    int32 changedTiles = 0;
+    ParallelFor(tilesX * tilesY, [&](int32 tile) {
+        bool changed = false;
+        ForTile(tile, [&](int i, int j, int32 index) {
+            uint8 r = carved[index].R;
+            carved[index] = heightmap[index];
+            carved[index].R = r;
+            if (full || height[index] != heightmap[index].R) {
+                height[index] = heightmap[index].R;
+                changed = true;
+            }
+        });
+        if (changed) {
+            inputTiles[tile] = 1;
+            FPlatformAtomics::InterlockedAdd(&changedTiles, 1);
+        }
+    });
+    if (changedTiles == 0 && carveKey == carvedWith) {
+        lastDirtyTiles = 0;
+        return false;
+    }
+
+    if (changedTiles > 0) {
+        Flood(full);
+        Route(full);
+        MarkDownstream(full);
+        Accumulate();
+    }
+    Carve(full || carveKey != carvedWith);
+
+    isValid = true;
+    routedWith = routing;
+    carvedWith = carveKey;
+    stats.bytesTouched = (int64)x * y * (sizeof(FColor) + sizeof(uint16) * 3 + sizeof(int32) + sizeof(uint8) * 5 + sizeof(float));
+    return true;
+}
+
+void ULanGenHydrologyObject::Flood(bool full)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_PriorityFlood);
+    ParallelFor(tilesX * tilesY, [&](int32 tile) {
+        if (inputTiles[tile]) FloodTile(tile);
+    });
+    ResolveSpill();
+
+    // a cell can not drain lower than the watershed it was flooded from
+    ParallelFor(tilesX * tilesY, [&](int32 tile) {
+        bool changed = false;
+        ForTile(tile, [&](int x, int y, int32 index) {
+            uint16 level = spill[label[index]] == NO_SPILL ? localFilled[index] : FMath::Max(localFilled[index], spill[label[index]]);
+            if (full || filled[index] != level) {
+                filled[index] = level;
+                changed = true;
+            }
+        });
+        if (changed) fillTiles[tile] = 1;
+    });
+}
+
+void ULanGenHydrologyObject::FloodTile(int32 tile)
+{
+    /*
+    * priority flood with one FIFO bucket per height level, seeded by every perimeter cell under
+    * its own label; a cell is raised to the level it was reached from and takes that label
+    */
+    int tx = tile / tilesY, ty = tile % tilesY,
+        x0 = tx * TILE, y0 = ty * TILE, x1 = FMath::Min(lanX, x0 + TILE), y1 = FMath::Min(lanY, y0 + TILE), width = y1 - y0;
+    FMemMark memMark(FMemStack::Get());
+    TArray<int32, TMemStackAllocator<>> queueNext;
+    TArray<uint8, TMemStackAllocator<>> visited;
+    queueNext.SetNumUninitialized((x1 - x0) * width);
+    visited.SetNumZeroed((x1 - x0) * width);
+    TMap<uint64, uint16> meets;
+    int32 head[LEVELS], tail[LEVELS];
+    for (int i = 0; i < LEVELS; ++i) head[i] = tail[i] = INDEX_NONE;
+
+    auto push = [&](int x, int y, int32 cellLabel, uint16 level) {
+        int32 local = (x - x0) * width + y - y0, index = x * lanY + y;
+        visited[local] = 1;
+        label[index] = cellLabel;
+        localFilled[index] = level;
+        queueNext[local] = INDEX_NONE;
+        if (tail[level] == INDEX_NONE) head[level] = local;
+        else queueNext[tail[level]] = local;
+        tail[level] = local;
+    };
+
+    int32 ordinal = labelBase[tile];
+    for (int x = x0; x < x1; ++x)
+        for (int y = y0; y < y1; y += (x == x0 || x == x1 - 1) ? 1 : FMath::Max(width - 1, 1))
+            push(x, y, ordinal++, height[x * lanY + y]);
+
+    for (int level = 0; level < LEVELS; ++level) {
+        while (head[level] != INDEX_NONE) {
+            int32 local = head[level];
+            head[level] = queueNext[local];
+            if (head[level] == INDEX_NONE) tail[level] = INDEX_NONE;
+            int x = x0 + local / width, y = y0 + local % width, index = x * lanY + y;
+            for (uint8 k = 0; k < 8; ++k) {
+                int nx = x + DX[k], ny = y + DY[k];
+                if (nx < x0 || nx >= x1 || ny < y0 || ny >= y1) continue;
+                int32 next = nx * lanY + ny;
+                if (!visited[(nx - x0) * width + ny - y0]) push(nx, ny, label[index], FMath::Max<uint16>(height[next], level));
+                else if (label[next] != label[index]) {
+                    // lowest pass between the two watersheds
+                    uint16 weight = FMath::Max(localFilled[index], localFilled[next]);
+                    uint16& pass = meets.FindOrAdd((uint64)FMath::Min(label[index], label[next]) << 32 | FMath::Max(label[index], label[next]), NO_SPILL);
+                    pass = FMath::Min(pass, weight);
+                }
+            }
+        }
+    }
+
+    TArray<spillEdge>& edges = tileEdges[tile];
+    edges.Reset(meets.Num());
+    for (const TPair<uint64, uint16>& i : meets) edges.Add({ (int32)(i.Key >> 32), (int32)(uint32)i.Key, i.Value });
+}
+
+void ULanGenHydrologyObject::ResolveSpill()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_ResolveSpill);
+    FMemMark memMark(FMemStack::Get());
+    TArray<spillEdge, TMemStackAllocator<>> edges;
+    for (const TArray<spillEdge>& i : tileEdges) edges.Append(i);
+
+    // perimeter cells of neighbouring tiles are connected at the higher of the two
+    for (int32 tile = 0; tile < tilesX * tilesY; ++tile) {
+        int tx = tile / tilesY, ty = tile % tilesY,
+            x0 = tx * TILE, y0 = ty * TILE, x1 = FMath::Min(lanX, x0 + TILE), y1 = FMath::Min(lanY, y0 + TILE);
+        for (int x = x0; x < x1; ++x) {
+            for (int y = y0; y < y1; y += (x == x0 || x == x1 - 1) ? 1 : FMath::Max(y1 - y0 - 1, 1)) {
+                int32 index = x * lanY + y;
+                for (uint8 k = 0; k < 8; ++k) {
+                    int nx = x + DX[k], ny = y + DY[k];
+                    if (nx < 0 || nx >= lanX || ny < 0 || ny >= lanY || (nx >= x0 && nx < x1 && ny >= y0 && ny < y1)) continue;
+                    int32 next = nx * lanY + ny;
+                    if (label[index] < label[next]) edges.Add({ label[index], label[next], FMath::Max(height[index], height[next]) });
+                }
+            }
+        }
+    }
+
+    TArray<int32, TMemStackAllocator<>> offset, to;
+    TArray<uint16, TMemStackAllocator<>> weight;
+    offset.SetNumZeroed(labelCount + 1);
+    for (const spillEdge& i : edges) {
+        ++offset[i.a + 1];
+        ++offset[i.b + 1];
+    }
+    for (int32 i = 0; i < labelCount; ++i) offset[i + 1] += offset[i];
+    to.SetNumUninitialized(edges.Num() * 2);
+    weight.SetNumUninitialized(edges.Num() * 2);
+    for (const spillEdge& i : edges) {
+        to[offset[i.a]] = i.b;
+        weight[offset[i.a]++] = i.weight;
+        to[offset[i.b]] = i.a;
+        weight[offset[i.b]++] = i.weight;
+    }
+    for (int32 i = labelCount; i > 0; --i) offset[i] = offset[i - 1];
+    offset[0] = 0;
+
+    // same priority flood over the watershed graph, from the cells on the map border
+    TArray<int32> buckets[LEVELS];
+    for (uint16& i : spill) i = NO_SPILL;
+    for (int x = 0; x < lanX; ++x) {
+        for (int y = 0; y < lanY; y += (x == 0 || x == lanX - 1) ? 1 : FMath::Max(lanY - 1, 1)) {
+            int32 index = x * lanY + y;
+            spill[label[index]] = height[index];
+            buckets[height[index]].Add(label[index]);
+        }
+    }
+    for (int level = 0; level < LEVELS; ++level) {
+        for (int i = 0; i < buckets[level].Num(); ++i) {
+            int32 node = buckets[level][i];
+            if (spill[node] != level) continue;
+            for (int32 j = offset[node]; j < offset[node + 1]; ++j) {
+                uint16 pass = FMath::Max<uint16>(level, weight[j]);
+                if (pass >= spill[to[j]]) continue;
+                spill[to[j]] = pass;
+                buckets[pass].Add(to[j]);
+            }
+        }
+    }
+}
+
+void ULanGenHydrologyObject::Route(bool full)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_FlowRouting);
+    // receivers look one cell past the tile edge
+    if (!full) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            for (int ty = 0; ty < tilesY; ++ty) {
+                if (!fillTiles[tx * tilesY + ty]) continue;
+                for (int i = FMath::Max(tx - 1, 0); i <= FMath::Min(tx + 1, tilesX - 1); ++i)
+                    for (int j = FMath::Max(ty - 1, 0); j <= FMath::Min(ty + 1, tilesY - 1); ++j)
+                        routeTiles[i * tilesY + j] = 1;
+            }
+        }
+    }
+
+    ParallelFor(tilesX * tilesY, [&](int32 tile) {
+        TArray<int32>& seeds = tileSeeds[tile];
+        TArray<int32>& flats = tileFlats[tile];
+        seeds.Reset();
+        flats.Reset();
+        if (!routeTiles[tile]) return;
+        ForTile(tile, [&](int x, int y, int32 index) {
+            uint8 r = NO_FLOW, r2 = NO_FLOW, s = 255;
+            if (x > 0 && x < lanX - 1 && y > 0 && y < lanY - 1) {
+                if (routing == ELanGenFlowRouting::D8) RouteD8(x, y, r);
+                else RouteDInfinity(x, y, r, r2, s);
+                if (r == NO_FLOW) {
+                    flats.Add(index);
+                    return;
+                }
+            }
+            if (!full && (r != receiver[index] || r2 != receiver2[index] || s != share[index])) {
+                // both the old and the new downstream paths change
+                seeds.Add(index);
+                if (receiver[index] != NO_FLOW) seeds.Add(index + DX[receiver[index]] * lanY + DY[receiver[index]]);
+                if (receiver2[index] != NO_FLOW) seeds.Add(index + DX[receiver2[index]] * lanY + DY[receiver2[index]]);
+            }
+            receiver[index] = r;
+            receiver2[index] = r2;
+            share[index] = s;
+        });
+    });
+    ResolveFlats(full);
+}
+
+void ULanGenHydrologyObject::ResolveFlats(bool full)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_ResolveFlats);
+    /*
+    * flats, filled pits included, drain breadth first towards the cells on their edge that can
+    * go lower; a flat touched by a routed tile is redone whole, in index order so the result
+    * does not depend on where it was entered from
+    */
+    const uint8 PENDING = NO_FLOW + 1;
+    FMemMark memMark(FMemStack::Get());
+    TBitArray<> inFlat(false, lanX * lanY);
+    TArray<int32, TMemStackAllocator<>> flat, queue;
+    TArray<uint32, TMemStackAllocator<>> old;
+
+    for (const TArray<int32>& flats : tileFlats) {
+        for (int32 start : flats) {
+            if (inFlat[start]) continue;
+            flat.Reset();
+            flat.Add(start);
+            inFlat[start] = true;
+            for (int i = 0; i < flat.Num(); ++i) {
+                int x = flat[i] / lanY, y = flat[i] % lanY;
+                for (uint8 k = 0; k < 8; ++k) {
+                    int32 next = flat[i] + DX[k] * lanY + DY[k];
+                    if (x + DX[k] < 0 || x + DX[k] >= lanX || y + DY[k] < 0 || y + DY[k] >= lanY) continue;
+                    if (inFlat[next] || filled[next] != filled[flat[i]] || !IsFlat(next)) continue;
+                    inFlat[next] = true;
+                    flat.Add(next);
+                }
+            }
+            flat.Sort();
+
+            old.Reset();
+            queue.Reset();
+            for (int32 index : flat) {
+                old.Add(receiver[index] | receiver2[index] << 8 | share[index] << 16);
+                receiver[index] = PENDING;
+                receiver2[index] = NO_FLOW;
+                share[index] = 255;
+            }
+            for (int32 index : flat) {
+                for (uint8 k = 0; k < 8; ++k) {
+                    int32 next = index + DX[k] * lanY + DY[k];
+                    // an equal neighbour outside the flat can go lower
+                    if (filled[next] != filled[index] || receiver[next] == PENDING) continue;
+                    receiver[index] = k;
+                    queue.Add(index);
+                    break;
+                }
+            }
+            for (int i = 0; i < queue.Num(); ++i) {
+                for (uint8 k = 0; k < 8; ++k) {
+                    int32 next = queue[i] + DX[k] * lanY + DY[k];
+                    if (receiver[next] != PENDING || filled[next] != filled[queue[i]]) continue;
+                    receiver[next] = Opposite(k);
+                    queue.Add(next);
+                }
+            }
+
+            for (int i = 0; i < flat.Num(); ++i) {
+                int32 index = flat[i];
+                // a flat with no way out can only be left by an unfilled input, make it a sink
+                if (receiver[index] == PENDING) receiver[index] = NO_FLOW;
+                uint8 oldReceiver = old[i] & 0xFF, oldReceiver2 = (old[i] >> 8) & 0xFF;
+                if (full || old[i] == (receiver[index] | receiver2[index] << 8 | share[index] << 16)) continue;
+                TArray<int32>& seeds = tileSeeds[TileOf(index)];
+                seeds.Add(index);
+                if (oldReceiver < NO_FLOW) seeds.Add(index + DX[oldReceiver] * lanY + DY[oldReceiver]);
+                if (oldReceiver2 < NO_FLOW) seeds.Add(index + DX[oldReceiver2] * lanY + DY[oldReceiver2]);
+            }
+        }
+    }
+}
+
+bool ULanGenHydrologyObject::IsFlat(int32 index) const
+{
+    int x = index / lanY, y = index % lanY;
+    if (x == 0 || x == lanX - 1 || y == 0 || y == lanY - 1) return false;
+    for (uint8 k = 0; k < 8; ++k)
+        if (filled[index + DX[k] * lanY + DY[k]] < filled[index]) return false;
+    return true;
+}
+
+void ULanGenHydrologyObject::RouteD8(int x, int y, uint8& out) const
+{
+    int32 index = x * lanY + y;
+    float steepest = 0;
+    for (uint8 k = 0; k < 8; ++k) {
+        float slope = (filled[index] - filled[index + DX[k] * lanY + DY[k]]) / DIST[k];
+        if (slope > steepest) {
+            steepest = slope;
+            out = k;
+        }
+    }
+}
+
+void ULanGenHydrologyObject::RouteDInfinity(int x, int y, uint8& out, uint8& out2, uint8& outShare) const
+{
+    /* Tarboton; 8 triangular facets between a cardinal and a diagonal neighbour */
+    int32 index = x * lanY + y;
+    float e0 = filled[index], steepest = 0, cardinalShare = 1;
+    uint8 cardinal = NO_FLOW, diagonal = NO_FLOW;
+    for (uint8 k = 0; k < 8; k += 2) {
+        for (uint8 d : { (uint8)((k + 1) & 7), (uint8)((k + 7) & 7) }) {
+            float e1 = filled[index + DX[k] * lanY + DY[k]], e2 = filled[index + DX[d] * lanY + DY[d]],
+                s1 = e0 - e1, s2 = e1 - e2, r = FMath::Atan2(s2, s1), slope;
+            if (r < 0) {
+                r = 0;
+                slope = s1;
+            }
+            else if (r > PI / 4) {
+                r = PI / 4;
+                slope = (e0 - e2) / UE_SQRT_2;
+            }
+            else slope = FMath::Sqrt(s1 * s1 + s2 * s2);
+            if (slope > steepest) {
+                steepest = slope;
+                cardinal = k;
+                diagonal = d;
+                cardinalShare = 1 - r / (PI / 4);
+            }
+        }
+    }
+    if (cardinal == NO_FLOW) return;
+
+    // only strictly lower receivers, otherwise flats could pass flow back and forth
+    bool cardinalLower = filled[index + DX[cardinal] * lanY + DY[cardinal]] < e0,
+        diagonalLower = filled[index + DX[diagonal] * lanY + DY[diagonal]] < e0;
+    uint8 s = FMath::RoundToInt(cardinalShare * 255);
+    if (!diagonalLower || s == 255) out = cardinal;
+    else if (!cardinalLower || s == 0) out = diagonal;
+    else {
+        out = cardinal;
+        out2 = diagonal;
+        outShare = s;
+    }
+}
+
+float ULanGenHydrologyObject::ShareTo(int32 from, uint8 dir) const
+{
+    if (receiver[from] == dir) return share[from] / 255.0f;
+    if (receiver2[from] == dir) return (255 - share[from]) / 255.0f;
+    return 0;
+}
+
+void ULanGenHydrologyObject::MarkDownstream(bool full)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_MarkDownstream);
+    FMemory::Memset(accDirty.GetData(), full ? 1 : 0, accDirty.Num());
+    if (full) return;
+
+    FMemMark memMark(FMemStack::Get());
+    TArray<int32, TMemStackAllocator<>> stack;
+    for (const TArray<int32>& seeds : tileSeeds) {
+        for (int32 index : seeds) {
+            if (accDirty[index]) continue;
+            accDirty[index] = 1;
+            stack.Add(index);
+        }
+    }
+    while (stack.Num() > 0) {
+        int32 index = stack.Pop(false);
+        accTiles[TileOf(index)] = 1;
+        for (uint8 dir : { receiver[index], receiver2[index] }) {
+            if (dir == NO_FLOW) continue;
+            int32 next = index + DX[dir] * lanY + DY[dir];
+            if (accDirty[next]) continue;
+            accDirty[next] = 1;
+            stack.Add(next);
+        }
+    }
+}
+
+void ULanGenHydrologyObject::Accumulate()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_FlowAccumulation);
+    // count dirty donors, cells without any are the sources
+    ParallelFor(tilesX * tilesY, [&](int32 tile) {
+        TArray<int32>& sources = tileSeeds[tile];
+        sources.Reset();
+        if (!accTiles[tile]) return;
+        ForTile(tile, [&](int x, int y, int32 index) {
+            if (!accDirty[index]) return;
+            int8 count = 0;
+            for (uint8 k = 0; k < 8; ++k) {
+                int nx = x + DX[k], ny = y + DY[k];
+                if (nx < 0 || nx >= lanX || ny < 0 || ny >= lanY) continue;
+                int32 next = nx * lanY + ny;
+                if (accDirty[next] && ShareTo(next, Opposite(k)) > 0) ++count;
+            }
+            donorCount[index] = count;
+            if (count == 0) sources.Add(index);
+        });
+    });
+
+    /*
+    * topological order without a global sort; a cell pulls from its donors once the last of
+    * them has finished, so the thread that finishes it carries on downstream even across tiles
+    */
+    int64 accumulated = 0;
+    ParallelFor(tilesX * tilesY, [&](int32 tile) {
+        if (tileSeeds[tile].Num() == 0) return;
+        FMemMark memMark(FMemStack::Get());
+        TArray<int32, TMemStackAllocator<>> stack;
+        stack.Append(tileSeeds[tile]);
+        int64 count = 0;
+        while (stack.Num() > 0) {
+            int32 index = stack.Pop(false);
+            int x = index / lanY, y = index % lanY;
+            float sum = 1;
+            for (uint8 k = 0; k < 8; ++k) {
+                int nx = x + DX[k], ny = y + DY[k];
+                if (nx < 0 || nx >= lanX || ny < 0 || ny >= lanY) continue;
+                int32 next = nx * lanY + ny;
+                float fraction = ShareTo(next, Opposite(k));
+                if (fraction > 0) sum += fraction * accumulation[next];
+            }
+            accumulation[index] = sum;
+            ++count;
+            for (uint8 dir : { receiver[index], receiver2[index] }) {
+                if (dir == NO_FLOW) continue;
+                int32 next = index + DX[dir] * lanY + DY[dir];
+                if (FPlatformAtomics::InterlockedAdd(&donorCount[next], (int8)-1) == 1) stack.Add(next);
+            }
+        }
+        FPlatformAtomics::InterlockedAdd(&accumulated, count);
+    });
+    stats.pixelsRasterized = accumulated;
+}
+
+void ULanGenHydrologyObject::Carve(bool full)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_RiverCarve);
+    int32 dirtyTiles = 0;
+    int64 written = 0;
+    ParallelFor(tilesX * tilesY, [&](int32 tile) {
+        if (!full && !inputTiles[tile] && !fillTiles[tile] && !accTiles[tile]) return;
+        int64 tileWritten = 0;
+        ForTile(tile, [&](int x, int y, int32 index) {
+            int base = fillDepressions ? filled[index] : height[index], depth = 0;
+            if (accumulation[index] > riverThreshold)
+                depth = FMath::Min(maxCarveDepth, FMath::RoundToInt(carveScale * FMath::Sqrt(accumulation[index] - riverThreshold)));
+            uint8 r = FMath::Clamp(base - depth, 0, 255);
+            if (carved[index].R != r) {
+                carved[index].R = r;
+                ++tileWritten;
+            }
+        });
+        FPlatformAtomics::InterlockedAdd(&dirtyTiles, 1);
+        FPlatformAtomics::InterlockedAdd(&written, tileWritten);
+    });
+    lastDirtyTiles = dirtyTiles;
+    stats.pixelsWritten = written;
+}
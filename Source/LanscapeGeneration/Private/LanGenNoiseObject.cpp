@@ -28,6 +28,9 @@
 */
 
 #include "LanGenNoiseObject.h"
+#include "LanGenContext.h"
+#include "Misc/MemStack.h"
+#include "Async/ParallelFor.h"
 
 void ULanGenNoiseObject::ResetSeed()
 {
@@ -39,13 +42,13 @@ void ULanGenNoiseObject::ResetSeed()
 void ULanGenNoiseObject::InitSeed(int32 in)
 {
     seed = in;
-    p.Empty();
-    p = P_BASE;
     randomEngine = FRandomStream(seed);
-    TArray<int> tempArray = P_BASE;
-    Shuffle(&tempArray);
-    p = tempArray;
-    p.Append(tempArray);
+    p = FLanGenContext::Get().Permutation(TEXT("Noise"), seed, [&](TArray<int>& out) {
+        TArray<int> tempArray = P_BASE;
+        Shuffle(&tempArray);
+        out = tempArray;
+        out.Append(tempArray);
+    });
 }
 
 float ULanGenNoiseObject::PerlinNoise3D(FVector location, int n, float lacunarity, float persistence, float in)
@@ -218,6 +221,139 @@ float ULanGenNoiseObject::SimplexNoise3D(FVector location, int n, float lacunari
     return in;
 }
 
+TArray<float> ULanGenNoiseObject::FbmField(int x, int y, float tileX, float tileY, int octaves, ELanGenNoiseType type, float lacunarity, float persistence, float z, bool adaptive)
+{
+    return FbmRegion(0, 0, x, y, tileX, tileY, octaves, type, lacunarity, persistence, z, adaptive);
+}
+
+TArray<float> ULanGenNoiseObject::FbmRegion(int x0, int y0, int x, int y, float tileX, float tileY, int octaves, ELanGenNoiseType type, float lacunarity, float persistence, float z, bool adaptive)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_FbmField);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Noise);
+    stats.Reset();
+    FLanGenStageTimer timer(stats.noiseMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
+    TArray<float> res;
+    if (x <= 0 || y <= 0 || x0 < 0 || y0 < 0 || tileX <= 0 || tileY <= 0 || !IsSeeded()) return res;
+    res.SetNumZeroed(x * y);
+    float* out = res.GetData();
+    int64 samples = 0;
+
+    for (int n = 0; n < octaves; ++n) {
+        // lattice cell of this octave in pixels; low octaves span hundreds
+        float frequency = FMath::Pow(lacunarity, n);
+        int spacingX = adaptive ? OctaveSpacing(tileX / frequency) : 1,
+            spacingY = adaptive ? OctaveSpacing(tileY / frequency) : 1;
+        if (spacingX == 1 && spacingY == 1) {
+            ParallelFor(x, [&](int32 i) {
+                for (int j = 0; j < y; ++j) out[i * y + j] += Octave(type, (x0 + i) / tileX, (y0 + j) / tileY, z, n, lacunarity, persistence);
+            });
+            samples += (int64)x * y;
+            continue;
+        }
+
+        // coarse grid from one spacing before the map to two after, the cubic taps reach that far
+        FMemMark memMark(FMemStack::Get());
+        TArray<float, TMemStackAllocator<>> coarse, rows;
+        TArray<upsampleTap, TMemStackAllocator<>> tapsX, tapsY;
+        int firstX = x0 / spacingX, firstY = y0 / spacingY,
+            coarseX = (x0 + x - 1) / spacingX - firstX + 4, coarseY = (y0 + y - 1) / spacingY - firstY + 4;
+        coarse.SetNumUninitialized(coarseX * coarseY);
+        rows.SetNumUninitialized(coarseX * y);
+        UpsampleTaps(x0, x, spacingX, tapsX);
+        UpsampleTaps(y0, y, spacingY, tapsY);
+        samples += (int64)coarseX * coarseY;
+
+        ParallelFor(coarseX, [&](int32 a) {
+            float locX = (firstX + a - 1) * spacingX / tileX;
+            for (int b = 0; b < coarseY; ++b) coarse[a * coarseY + b] = Octave(type, locX, (firstY + b - 1) * spacingY / tileY, z, n, lacunarity, persistence);
+        });
+        // separable: along y into full length coarse rows, then blend 4 rows per output row
+        ParallelFor(coarseX, [&](int32 a) {
+            const float* from = coarse.GetData() + a * coarseY;
+            float* to = rows.GetData() + a * y;
+            for (int j = 0; j < y; ++j) {
+                const upsampleTap& tap = tapsY[j];
+                const float* c = from + tap.k;
+                to[j] = tap.w[0] * c[0] + tap.w[1] * c[1] + tap.w[2] * c[2] + tap.w[3] * c[3];
+            }
+        });
+        ParallelFor(x, [&](int32 i) {
+            const upsampleTap& tap = tapsX[i];
+            const float* RESTRICT r0 = rows.GetData() + tap.k * y;
+            const float* RESTRICT r1 = r0 + y;
+            const float* RESTRICT r2 = r1 + y;
+            const float* RESTRICT r3 = r2 + y;
+            float* RESTRICT row = out + i * y;
+            float w0 = tap.w[0], w1 = tap.w[1], w2 = tap.w[2], w3 = tap.w[3];
+            // no cross iteration state, vectorizes
+            for (int j = 0; j < y; ++j) row[j] += w0 * r0[j] + w1 * r1[j] + w2 * r2[j] + w3 * r3[j];
+        });
+        stats.bytesTouched += ((int64)coarseX * coarseY + (int64)coarseX * y * 2) * sizeof(float);
+    }
+    stats.pixelsRasterized = samples;
+    stats.pixelsWritten = (int64)x * y;
+    stats.bytesTouched += (int64)x * y * sizeof(float) * 2 * octaves;
+    return res;
+}
+
+FLanGenNoiseBenchmark ULanGenNoiseObject::BenchmarkFbmField(int x, int y, float tileX, float tileY, int octaves, ELanGenNoiseType type, float lacunarity, float persistence, float z)
+{
+    FLanGenNoiseBenchmark res;
+    TArray<float> exact = FbmField(x, y, tileX, tileY, octaves, type, lacunarity, persistence, z, false);
+    res.exactMs = stats.noiseMs;
+    res.exactSamples = stats.pixelsRasterized;
+    TArray<float> approx = FbmField(x, y, tileX, tileY, octaves, type, lacunarity, persistence, z, true);
+    res.adaptiveMs = stats.noiseMs;
+    res.adaptiveSamples = stats.pixelsRasterized;
+
+    double sum = 0;
+    for (int i = 0; i < exact.Num(); ++i) {
+        float error = FMath::Abs(exact[i] - approx[i]);
+        res.maxError = FMath::Max(res.maxError, error);
+        sum += (double)error * error;
+    }
+    res.rmsError = exact.Num() > 0 ? FMath::Sqrt(sum / exact.Num()) : 0;
+    return res;
+}
+
+float ULanGenNoiseObject::Octave(ELanGenNoiseType type, float x, float y, float z, int n, float lacunarity, float persistence)
+{
+    return type == ELanGenNoiseType::Simplex
+        ? SimplexNoise3D(FVector(x, y, z), n, lacunarity, persistence)
+        : PerlinNoise3D(FVector(x, y, z), n, lacunarity, persistence);
+}
+
+int ULanGenNoiseObject::OctaveSpacing(float cellPixels) const
+{
+    if (nyquistMargin <= 0) return 1;
+    return FMath::Max(1, FMath::FloorToInt(cellPixels / (2 * nyquistMargin)));
+}
+
+void ULanGenNoiseObject::UpsampleTaps(int first, int num, int spacing, TArray<upsampleTap, TMemStackAllocator<>>& out) const
+{
+    out.SetNumUninitialized(num);
+    for (int i = 0; i < num; ++i) {
+        upsampleTap& tap = out[i];
+        int pixel = first + i;
+        float t = (float)(pixel % spacing) / spacing;
+        // grid starts one spacing early, so k + 1 is the sample at or left of the pixel
+        tap.k = pixel / spacing - first / spacing;
+        if (cubicUpsample) {
+            tap.w[0] = t * ((2 - t) * t - 1) / 2;
+            tap.w[1] = (t * t * (3 * t - 5) + 2) / 2;
+            tap.w[2] = t * ((4 - 3 * t) * t + 1) / 2;
+            tap.w[3] = (t - 1) * t * t / 2;
+        }
+        else {
+            tap.w[0] = 0;
+            tap.w[1] = 1 - t;
+            tap.w[2] = t;
+            tap.w[3] = 0;
+        }
+    }
+}
+
 float ULanGenNoiseObject::Fade(float t) { return t * t * t * (t * (t * 6 - 15) + 10); }
 
 float ULanGenNoiseObject::Lerp(float t, float a, float b) { return a + t * (b - a); }
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenPreviewTextureManager.h"
+#include "Engine/Texture2D.h"
+#include "LanGenStats.h"
+
+UTexture2D* ULanGenPreviewTextureManager::Update(int x, int y, const TArray<FColor>& colorData)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_PreviewUpdate);
+    lastUploadPixels = 0;
+    if (x <= 0 || y <= 0 || colorData.Num() != x * y) return nullptr;
+
+    UTexture2D* texture = FindOrCreate(x, y);
+    TArray<uint16>& current = uploaded.FindOrAdd(FIntPoint(x, y));
+    bool isFresh = current.Num() != x * y;
+    if (isFresh) current.SetNumZeroed(x * y);
+
+    // same layout as FImageUtils::CreateTexture2D; row r holds x pixels. 8 bit R widened to 16 bit
+    for (int band = 0; band < y; band += BAND_HEIGHT) {
+        int minX = x, maxX = -1, bandEnd = FMath::Min(band + BAND_HEIGHT, y);
+        for (int row = band; row < bandEnd; ++row) {
+            for (int col = 0; col < x; ++col) {
+                int index = row * x + col;
+                uint16 value = colorData[index].R * 257;
+                if (!isFresh && value == current[index]) continue;
+                current[index] = value;
+                minX = FMath::Min(minX, col);
+                maxX = FMath::Max(maxX, col);
+            }
+        }
+        if (maxX >= minX) UploadRect(texture, current, x, minX, band, maxX, bandEnd - 1);
+    }
+    return texture;
+}
+
+void ULanGenPreviewTextureManager::Release()
+{
+    textures.Empty();
+    uploaded.Empty();
+}
+
+UTexture2D* ULanGenPreviewTextureManager::FindOrCreate(int x, int y)
+{
+    UTexture2D*& texture = textures.FindOrAdd(FIntPoint(x, y));
+    if (texture) return texture;
+
+    texture = UTexture2D::CreateTransient(x, y, PF_G16, *FString::Printf(TEXT("LanGenPreview_%dx%d"), x, y));
+    texture->SRGB = false;
+    texture->Filter = TF_Nearest;
+    texture->UpdateResource();
+    uploaded.Remove(FIntPoint(x, y)); // new resource, nothing on the GPU yet
+    return texture;
+}
+
+void ULanGenPreviewTextureManager::UploadRect(UTexture2D* texture, const TArray<uint16>& src, int x, int minX, int minY, int maxX, int maxY)
+{
+    int width = maxX - minX + 1, height = maxY - minY + 1;
+    // the render thread reads after this returns; hand it a compact copy it frees itself
+    uint16* data = new uint16[width * height];
+    for (int row = 0; row < height; ++row)
+        FMemory::Memcpy(data + row * width, src.GetData() + (minY + row) * x + minX, width * sizeof(uint16));
+
+    FUpdateTextureRegion2D* region = new FUpdateTextureRegion2D(minX, minY, 0, 0, width, height);
+    texture->UpdateTextureRegions(0, 1, region, width * sizeof(uint16), sizeof(uint16), (uint8*)data,
+        [](uint8* srcData, const FUpdateTextureRegion2D* regions) {
+            delete[] (uint16*)srcData;
+            delete regions;
+        });
+    lastUploadPixels += (int64)width * height;
+}
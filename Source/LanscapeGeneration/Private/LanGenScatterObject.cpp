@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenScatterObject.h"
+#include "LanGenDerivedLayerObject.h"
+#include "LanGenElevationObject.h"
+#include "LanGenDistanceField.h"
+#include "LanGenRandom.h"
+#include "Misc/MemStack.h"
+#include "Async/ParallelFor.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "GameFramework/Actor.h"
+
+void ULanGenScatterObject::Scatter(const TArray<FColor>& heightmap, int x, int y, ULanGenDerivedLayerObject* derived, ULanGenElevationObject* elevation)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_Scatter);
+    SCOPE_CYCLE_COUNTER(STAT_LanGen_Scatter);
+    stats.Reset();
+    FLanGenStageTimer timer(stats.totalMs);
+    FLanGenAllocationScope allocationScope(stats.allocations);
+    transforms.SetNum(layers.Num());
+    for (TArray<FTransform>& i : transforms) i.Reset();
+    if (x <= 0 || y <= 0 || heightmap.Num() != x * y) return;
+    lanX = x;
+    lanY = y;
+
+    const TArray<float>* slope = (derived && derived->SlopeView().Num() == x * y) ? &derived->SlopeView() : nullptr;
+    const TArray<uint8>* weights = (derived && derived->GetLayerStride() == x * y) ? &derived->WeightView() : nullptr;
+
+    // distance to the main ridges through the nearest ridge pixel, only when a layer asks for it
+    TArray<int32> ridgeNearest;
+    bool useRidge = false;
+    for (const FLanGenScatterLayer& i : layers) useRidge |= i.minRidgeDistance > 0 || i.maxRidgeDistance < x + y;
+    if (useRidge && elevation && elevation->RidgePointsView().Num() > 0) {
+        ridgeNearest.Init(INDEX_NONE, x * y);
+        for (const FIntPoint& i : elevation->RidgePointsView())
+            if (i.X >= 0 && i.X < x && i.Y >= 0 && i.Y < y) ridgeNearest[i.X * y + i.Y] = i.X * y + i.Y;
+        FLanGenDistanceField::NearestSeed(ridgeNearest, x, y, true);
+    }
+
+    for (int i = 0; i < layers.Num(); ++i) {
+        ScatterLayer(i, heightmap, slope, weights, ridgeNearest.Num() > 0 ? &ridgeNearest : nullptr);
+        stats.pixelsWritten += transforms[i].Num();
+    }
+    stats.bytesTouched = stats.pixelsWritten * sizeof(FTransform);
+}
+
+void ULanGenScatterObject::ScatterLayer(int layerIndex, const TArray<FColor>& heightmap, const TArray<float>* slope, const TArray<uint8>* weights, const TArray<int32>* ridgeNearest)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_ScatterLayer);
+    const FLanGenScatterLayer& layer = layers[layerIndex];
+    if (layer.density <= 0 || layer.radius <= 0) return;
+    if (weights && layer.weightLayer >= 0 && (layer.weightLayer + 1) * lanX * lanY > weights->Num()) weights = nullptr;
+
+    // a disk never reaches past the cells two steps away
+    float radius = FMath::Max(layer.radius, 0.5f), radiusSq = radius * radius, cellSize = radius / UE_SQRT_2;
+    int gridX = FMath::CeilToInt(lanX / cellSize), gridY = FMath::CeilToInt(lanY / cellSize),
+        tilesX = FMath::DivideAndRoundUp(gridX, TILE_CELLS), tilesY = FMath::DivideAndRoundUp(gridY, TILE_CELLS);
+    TArray<FVector2D> grid; // one point per cell at most, X < 0 = empty
+    grid.Init(FVector2D(-1, -1), gridX * gridY);
+    TArray<TArray<FTransform>> tileOut;
+    tileOut.SetNum(tilesX * tilesY);
+    FLanGenRandom random(seed);
+    FVector landscapeScale = landscapeTransform.GetScale3D();
+    int64 candidates = 0;
+
+    for (int colour = 0; colour < 4; ++colour) {
+        int colourX = colour >> 1, colourY = colour & 1,
+            countX = (tilesX - colourX + 1) / 2, countY = (tilesY - colourY + 1) / 2;
+        ParallelFor(countX * countY, [&](int32 i) {
+            int tx = colourX + 2 * (i / countY), ty = colourY + 2 * (i % countY), tile = tx * tilesY + ty,
+                cellX0 = tx * TILE_CELLS, cellY0 = ty * TILE_CELLS,
+                cellX1 = FMath::Min(gridX, cellX0 + TILE_CELLS), cellY1 = FMath::Min(gridY, cellY0 + TILE_CELLS);
+            float x0 = cellX0 * cellSize, y0 = cellY0 * cellSize,
+                x1 = FMath::Min((float)lanX, cellX1 * cellSize), y1 = FMath::Min((float)lanY, cellY1 * cellSize);
+            // every draw is keyed by (layer, tile, n) so the result does not depend on scheduling
+            uint32 key = layerIndex * tilesX * tilesY + tile, draw = 0;
+            auto rand = [&]() { return random.FRand(LanGenStream::Scatter, FLanGenRandom::Key(key, draw++)); };
+
+            FMemMark memMark(FMemStack::Get());
+            TArray<FVector2D, TMemStackAllocator<>> points, active;
+            int64 tried = 0;
+            auto tryAdd = [&](const FVector2D& point) {
+                ++tried;
+                if (point.X < x0 || point.X >= x1 || point.Y < y0 || point.Y >= y1) return false;
+                int cx = FMath::Clamp(FMath::FloorToInt(point.X / cellSize), cellX0, cellX1 - 1),
+                    cy = FMath::Clamp(FMath::FloorToInt(point.Y / cellSize), cellY0, cellY1 - 1);
+                for (int gx = FMath::Max(cx - 2, 0); gx <= FMath::Min(cx + 2, gridX - 1); ++gx) {
+                    for (int gy = FMath::Max(cy - 2, 0); gy <= FMath::Min(cy + 2, gridY - 1); ++gy) {
+                        const FVector2D& other = grid[gx * gridY + gy];
+                        if (other.X >= 0 && FVector2D::DistSquared(point, other) < radiusSq) return false;
+                    }
+                }
+                grid[cx * gridY + cy] = point;
+                points.Add(point);
+                active.Add(point);
+                return true;
+            };
+
+            // Bridson; darts to start from, then grow around active points until they run out of room
+            for (int k = 0; k < attempts; ++k) tryAdd(FVector2D(x0 + rand() * (x1 - x0), y0 + rand() * (y1 - y0)));
+            while (active.Num() > 0) {
+                int a = FMath::Min((int)(rand() * active.Num()), active.Num() - 1);
+                FVector2D center = active[a];
+                bool found = false;
+                for (int k = 0; k < attempts && !found; ++k) {
+                    float angle = rand() * 2 * PI, distance = radius * (1 + rand());
+                    found = tryAdd(center + FVector2D(FMath::Cos(angle), FMath::Sin(angle)) * distance);
+                }
+                if (!found) active.RemoveAtSwap(a, 1, false);
+            }
+
+            // thin by the density mask; spacing only grows so the disks stay valid
+            TArray<FTransform>& out = tileOut[tile];
+            for (const FVector2D& point : points) {
+                int px = FMath::Min((int)point.X, lanX - 1), py = FMath::Min((int)point.Y, lanY - 1), index = px * lanY + py;
+                float height = HeightAt(heightmap, point.X, point.Y),
+                    dx = (heightmap[FMath::Min(px + 1, lanX - 1) * lanY + py].R - heightmap[FMath::Max(px - 1, 0) * lanY + py].R) * 0.5f,
+                    dy = (heightmap[px * lanY + FMath::Min(py + 1, lanY - 1)].R - heightmap[px * lanY + FMath::Max(py - 1, 0)].R) * 0.5f,
+                    pointSlope = slope ? (*slope)[index] : FMath::RadiansToDegrees(FMath::Atan(FMath::Sqrt(dx * dx + dy * dy))),
+                    mask = layer.density *
+                        ULanGenDerivedLayerObject::Band(height, layer.minHeight, layer.maxHeight, layer.heightBlend) *
+                        ULanGenDerivedLayerObject::Band(pointSlope, layer.minSlope, layer.maxSlope, layer.slopeBlend);
+                if (ridgeNearest) {
+                    int32 nearest = (*ridgeNearest)[index];
+                    float distance = nearest == INDEX_NONE ? MAX_flt :
+                        FMath::Sqrt((float)FMath::Square(nearest / lanY - px) + FMath::Square(nearest % lanY - py));
+                    mask *= ULanGenDerivedLayerObject::Band(distance, layer.minRidgeDistance, layer.maxRidgeDistance, layer.ridgeBlend);
+                }
+                if (weights && layer.weightLayer >= 0) mask *= (*weights)[layer.weightLayer * lanX * lanY + index] / 255.0f;
+                if (mask <= 0 || rand() >= mask) continue;
+
+                FQuat rotation(FVector::UpVector, rand() * 2 * PI);
+                float scale = FMath::Lerp(layer.minScale, layer.maxScale, rand());
+                if (layer.alignToNormal) {
+                    // pixel x is landscape Y
+                    FVector normal(-dy * zPerHeight * landscapeScale.Z / landscapeScale.X, -dx * zPerHeight * landscapeScale.Z / landscapeScale.Y, 1);
+                    rotation = FQuat::FindBetweenNormals(FVector::UpVector, normal.GetSafeNormal()) * rotation;
+                }
+                out.Add(FTransform(
+                    landscapeTransform.GetRotation() * rotation,
+                    landscapeTransform.TransformPosition(FVector(point.Y, point.X, height * zPerHeight + zOffset)),
+                    FVector(scale)));
+            }
+            FPlatformAtomics::InterlockedAdd(&candidates, tried);
+        });
+    }
+
+    TArray<FTransform>& out = transforms[layerIndex];
+    int32 total = 0;
+    for (const TArray<FTransform>& i : tileOut) total += i.Num();
+    out.Reserve(total);
+    for (const TArray<FTransform>& i : tileOut) out.Append(i);
+    stats.pixelsRasterized += candidates;
+}
+
+float ULanGenScatterObject::HeightAt(const TArray<FColor>& heightmap, float x, float y) const
+{
+    int x0 = FMath::Clamp(FMath::FloorToInt(x - 0.5f), 0, lanX - 1), y0 = FMath::Clamp(FMath::FloorToInt(y - 0.5f), 0, lanY - 1),
+        x1 = FMath::Min(x0 + 1, lanX - 1), y1 = FMath::Min(y0 + 1, lanY - 1);
+    float fx = FMath::Clamp(x - 0.5f - x0, 0.0f, 1.0f), fy = FMath::Clamp(y - 0.5f - y0, 0.0f, 1.0f);
+    return FMath::BiLerp<float>(heightmap[x0 * lanY + y0].R, heightmap[x1 * lanY + y0].R,
+        heightmap[x0 * lanY + y1].R, heightmap[x1 * lanY + y1].R, fx, fy);
+}
+
+int ULanGenScatterObject::SpawnInstances(AActor* owner)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(LanGen_SpawnInstances);
+    if (!owner) return 0;
+    int added = 0;
+    components.SetNum(layers.Num());
+    for (int i = 0; i < layers.Num() && i < transforms.Num(); ++i) {
+        UHierarchicalInstancedStaticMeshComponent*& component = components[i];
+        if (!layers[i].mesh || transforms[i].Num() == 0) {
+            if (component) component->ClearInstances();
+            continue;
+        }
+        if (!component || component->GetOwner() != owner) {
+            component = NewObject<UHierarchicalInstancedStaticMeshComponent>(owner, NAME_None, RF_Transactional);
+            component->SetupAttachment(owner->GetRootComponent());
+            component->RegisterComponent();
+            owner->AddInstanceComponent(component);
+        }
+        else component->ClearInstances();
+        component->SetStaticMesh(layers[i].mesh);
+
+        // instances are relative to the component; one tree rebuild per batch instead of per instance
+        const FTransform& componentTransform = component->GetComponentTransform();
+        TArray<FTransform> batch;
+        batch.Reserve(FMath::Min(BATCH, transforms[i].Num()));
+        for (int start = 0; start < transforms[i].Num(); start += BATCH) {
+            batch.Reset();
+            for (int j = start; j < FMath::Min(start + BATCH, transforms[i].Num()); ++j)
+                batch.Add(transforms[i][j].GetRelativeTransform(componentTransform));
+            component->AddInstances(batch, false);
+        }
+        added += transforms[i].Num();
+    }
+    return added;
+}
+
+void ULanGenScatterObject::ClearInstances()
+{
+    for (UHierarchicalInstancedStaticMeshComponent* i : components)
+        if (i) i->ClearInstances();
+}
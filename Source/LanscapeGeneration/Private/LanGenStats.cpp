@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenStats.h"
+
+DEFINE_STAT(STAT_LanGen_RuleApply);
+DEFINE_STAT(STAT_LanGen_Turtle);
+DEFINE_STAT(STAT_LanGen_Midpoint);
+DEFINE_STAT(STAT_LanGen_Gradient);
+DEFINE_STAT(STAT_LanGen_Draw);
+DEFINE_STAT(STAT_LanGen_Noise);
+DEFINE_STAT(STAT_LanGen_Derived);
+DEFINE_STAT(STAT_LanGen_Hydrology);
+DEFINE_STAT(STAT_LanGen_Scatter);
+DEFINE_STAT(STAT_LanGen_Heightfield);
+
+DEFINE_STAT(STAT_LanGen_GrammarLength);
+DEFINE_STAT(STAT_LanGen_TurtleOps);
+DEFINE_STAT(STAT_LanGen_Strokes);
+DEFINE_STAT(STAT_LanGen_PixelsRasterized);
+DEFINE_STAT(STAT_LanGen_PixelsWritten);
+DEFINE_STAT(STAT_LanGen_StampsRejected);
+DEFINE_STAT(STAT_LanGen_Allocations);
+DEFINE_STAT(STAT_LanGen_BytesTouched);
+DEFINE_STAT(STAT_LanGen_ArenaBytes);
+
+void FLanGenStats::Append(const FLanGenStats& other)
+{
+    totalMs += other.totalMs;
+    ruleApplyMs += other.ruleApplyMs;
+    turtleMs += other.turtleMs;
+    midpointMs += other.midpointMs;
+    gradientMs += other.gradientMs;
+    drawMs += other.drawMs;
+    noiseMs += other.noiseMs;
+    grammarLength += other.grammarLength;
+    turtleOps += other.turtleOps;
+    strokeCount += other.strokeCount;
+    pixelsRasterized += other.pixelsRasterized;
+    pixelsWritten += other.pixelsWritten;
+    stampsRejected += other.stampsRejected;
+    allocations += other.allocations;
+    bytesTouched += other.bytesTouched;
+    arenaBytes = FMath::Max(arenaBytes, other.arenaBytes);
+}
+
+FString FLanGenStats::ToString() const
+{
+    return FString::Printf(
+        TEXT("total %.2fms | rule %.2fms turtle %.2fms midpoint %.2fms gradient %.2fms draw %.2fms noise %.2fms | ")
+        TEXT("grammar %lld ops %lld strokes %lld rasterized %lld written %lld overdraw %.2f rejected %lld allocs %lld arena %.1fMB touched %.1fMB"),
+        totalMs, ruleApplyMs, turtleMs, midpointMs, gradientMs, drawMs, noiseMs,
+        grammarLength, turtleOps, strokeCount, pixelsRasterized, pixelsWritten, OverdrawRatio(), stampsRejected,
+        allocations, arenaBytes / (1024.0 * 1024.0), bytesTouched / (1024.0 * 1024.0)
+    );
+}
+
+void FLanGenStats::Publish(bool add) const
+{
+    if (add) {
+        INC_DWORD_STAT_BY(STAT_LanGen_GrammarLength, grammarLength);
+        INC_DWORD_STAT_BY(STAT_LanGen_TurtleOps, turtleOps);
+        INC_DWORD_STAT_BY(STAT_LanGen_Strokes, strokeCount);
+        INC_DWORD_STAT_BY(STAT_LanGen_PixelsRasterized, pixelsRasterized);
+        INC_DWORD_STAT_BY(STAT_LanGen_PixelsWritten, pixelsWritten);
+        INC_DWORD_STAT_BY(STAT_LanGen_StampsRejected, stampsRejected);
+        INC_DWORD_STAT_BY(STAT_LanGen_Allocations, allocations);
+        INC_MEMORY_STAT_BY(STAT_LanGen_BytesTouched, bytesTouched);
+        INC_MEMORY_STAT_BY(STAT_LanGen_ArenaBytes, arenaBytes);
+        return;
+    }
+    SET_DWORD_STAT(STAT_LanGen_GrammarLength, grammarLength);
+    SET_DWORD_STAT(STAT_LanGen_TurtleOps, turtleOps);
+    SET_DWORD_STAT(STAT_LanGen_Strokes, strokeCount);
+    SET_DWORD_STAT(STAT_LanGen_PixelsRasterized, pixelsRasterized);
+    SET_DWORD_STAT(STAT_LanGen_PixelsWritten, pixelsWritten);
+    SET_DWORD_STAT(STAT_LanGen_StampsRejected, stampsRejected);
+    SET_DWORD_STAT(STAT_LanGen_Allocations, allocations);
+    SET_MEMORY_STAT(STAT_LanGen_BytesTouched, bytesTouched);
+    SET_MEMORY_STAT(STAT_LanGen_ArenaBytes, arenaBytes);
+}
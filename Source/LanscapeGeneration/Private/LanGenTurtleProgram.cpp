@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LanGenTurtleProgram.h"
+
+void FLanGenTurtleProgram::Compile(const FString& grammar, const FLanGenRandom& random, int minAngle, int maxAngle)
+{
+    bool isRandomAngle = minAngle != maxAngle;
+    uint32 turnCount = 0, moves = 0;
+    int turn = 0, depth = 0, steps = 0;
+    bool hasTurn = false;
+
+    ops.Reset();
+    grammarLength = grammar.Len();
+    maxDepth = 0;
+    maxLineSteps = 0;
+
+    // a run is only cut by a symbol that reads or changes the line; a turn that sums to 0 does neither
+    auto flushTurn = [&]() {
+        if (hasTurn && turn != 0) Emit(LanGenTurtleOp::Turn, turn);
+        hasTurn = false;
+        turn = 0;
+    };
+    auto flush = [&]() {
+        if (moves > 0) Emit(LanGenTurtleOp::Move, moves);
+        moves = 0;
+        flushTurn();
+    };
+
+    for (TCHAR i : grammar) {
+        switch (i) {
+        case 'F':
+        case 'D':
+            if (hasTurn && turn != 0) flush();
+            hasTurn = false;
+            if (moves == MAX_ARG) flush();
+            ++moves;
+            maxLineSteps = FMath::Max(maxLineSteps, ++steps);
+            break;
+        case '+':
+        case '-': {
+            int angle = isRandomAngle ? random.RandRange(LanGenStream::Turtle, turnCount++, minAngle, maxAngle) : minAngle;
+            turn = (turn + (i == '+' ? angle : -angle) % 360 + 360) % 360;
+            hasTurn = true;
+            break;
+        }
+        case 'P': flush(); Emit(LanGenTurtleOp::Peak); break;
+        case 'L': flush(); Emit(LanGenTurtleOp::Main); break;
+        case 'E': flush(); Emit(LanGenTurtleOp::Detail); break;
+        case '[':
+            flush();
+            Emit(LanGenTurtleOp::Push, depth++);
+            maxDepth = FMath::Max(maxDepth, depth);
+            break;
+        case ']':
+            if (depth == 0) break;
+            flush();
+            Emit(LanGenTurtleOp::Pop, --depth);
+            steps = 0;
+            break;
+        }
+    }
+    flush();
+}
@@ -1,18 +1,21 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "LanscapeGeneration.h"
+#include "LanGenContext.h"
 
 #define LOCTEXT_NAMESPACE "FLanscapeGenerationModule"
 
 void FLanscapeGenerationModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	context = MakeUnique<FLanGenContext>();
 }
 
 void FLanscapeGenerationModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	context.Reset();
 }
 
 #undef LOCTEXT_NAMESPACE
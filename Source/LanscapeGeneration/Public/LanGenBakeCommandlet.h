@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LanGenBakeCommandlet.generated.h"
+
+/**
+ * Headless tile bake.
+ * coordinator: -run=LanGenBake -size=8192 -tile=512 -workers=4 -seed=0 -octaves=8 -scale=512 -output=<file> [-port=N -bind=<ip> -noSpawn]
+ * worker:      -run=LanGenBake -worker -port=N -id=I [-host=<coordinator ip> -idle=<seconds>]
+ * for several machines, bind the coordinator to 0.0.0.0 with a fixed port and -noSpawn, then start workers with distinct ids elsewhere
+ */
+UCLASS()
+class LANSCAPEGENERATION_API ULanGenBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	ULanGenBakeCommandlet();
+
+	virtual int32 Main(const FString& params) override;
+};
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "HAL/PlatformProcess.h"
+#include "LanGenStats.h"
+#include "LanGenBakeProtocol.h"
+#include "LanGenBakeCoordinator.generated.h"
+
+/**
+ * Splits the map in tiles and hands them to worker processes over loopback sockets, one job in
+ * flight per worker, then stitches the results. The field is position keyed and every octave grid
+ * sits on map multiples, so tiles need no halo and join without seams.
+ * A tile lost to a failure report, a dead worker or a timeout goes back in the queue; a tile that
+ * fails more than maxRetries times fails the bake.
+ */
+UCLASS(BlueprintType)
+class LANSCAPEGENERATION_API ULanGenBakeCoordinator : public UObject
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		FLanGenBakeNoise noise;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		int workers = 4;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		int tileSize = 512;
+	/* attempts per tile after the first, and respawns per worker */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		int maxRetries = 3;
+	/* seconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float jobTimeout = 120;
+	/* seconds a spawned worker has to say hello, or a manual bake waits without any worker */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float connectTimeout = 60;
+	/* 0 picks a free port */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		int32 port = 0;
+	/*
+	* IPv4 address to listen on, empty for loopback only; 0.0.0.0 or a LAN address lets workers on other machines join.
+	* the stream is neither authenticated nor encrypted, so only open it on a trusted network
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		FString bindAddress;
+	/* false waits for workers started by hand with -run=LanGenBake -worker -host= -port= -id=, on this machine or others */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		bool spawnWorkers = true;
+private:
+	struct workerSlot {
+		int32 id = INDEX_NONE;
+		FLanGenBakeChannel channel;
+		FProcHandle proc;
+		/* tile in flight */
+		int32 tile = INDEX_NONE;
+		double sentAt = 0, spawnedAt = 0;
+		int respawns = 0;
+		bool isAlive = false;
+	};
+
+	int lanX = 0, lanY = 0, tilesX = 0, tilesY = 0;
+	TArray<float> heights;
+	TArray<FLanGenBakeWorkerStats> workerStats;
+	FLanGenStats stats;
+public:
+	/* blocks until every tile is in or the bake fails */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Bake")
+		bool Bake(int x, int y);
+
+	UFUNCTION(BlueprintCallable, Category = "LanGen Bake")
+		TArray<float> GetHeights() const { return heights; }
+	const TArray<float>& HeightsView() const { return heights; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Bake")
+		TArray<FLanGenBakeWorkerStats> GetWorkerStats() const { return workerStats; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Bake")
+		FLanGenStats GetLastStats() const { return stats; }
+private:
+	bool Spawn(workerSlot& slot, const FString& listenHost, int32 listenPort);
+	/* closes the link, kills a spawned process and queues its tile again */
+	void Drop(workerSlot& slot, TArray<int32>& queue, TArray<int32>& attempts, const TCHAR* reason);
+	FLanGenBakeWorkerStats& StatsOf(int32 id);
+	FLanGenBakeJob MakeJob(int32 tile) const;
+};
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "LanGenNoiseObject.h"
+#include "LanGenBakeProtocol.generated.h"
+
+class FSocket;
+
+/* message = uint32 payload bytes | uint8 type | payload */
+namespace LanGenBakeMessage
+{
+	enum Type : uint8
+	{
+		/* worker -> coordinator: int32 worker id */
+		Hello,
+		/* coordinator -> worker: FLanGenBakeJob */
+		Job,
+		/* worker -> coordinator: FLanGenBakeResult */
+		Result,
+		/* worker -> coordinator: int32 tile, FString reason */
+		Failed,
+		/* coordinator -> worker: no payload */
+		Quit,
+	};
+}
+
+/* fBm field a bake produces; sent with every job so a worker keeps no state between jobs */
+USTRUCT(BlueprintType)
+struct LANSCAPEGENERATION_API FLanGenBakeNoise
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		int32 seed = 0;
+	/* pixels per noise unit, as in ULanGenNoiseObject::FbmField */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float tileX = 512;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float tileY = 512;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		int octaves = 8;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		ELanGenNoiseType type = ELanGenNoiseType::Perlin;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float lacunarity = 2;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float persistence = 0.5;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float z = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		bool adaptive = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float nyquistMargin = 3;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		bool cubicUpsample = true;
+
+	friend FArchive& operator<<(FArchive& ar, FLanGenBakeNoise& in);
+};
+
+USTRUCT(BlueprintType)
+struct LANSCAPEGENERATION_API FLanGenBakeWorkerStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Bake")
+		int32 worker = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Bake")
+		int32 tilesDone = 0;
+	/* jobs lost to a failure report, a dropped connection or a timeout */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Bake")
+		int32 tilesFailed = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Bake")
+		int64 pixels = 0;
+	/* worker side compute time of the finished tiles */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Bake")
+		float computeMs = 0;
+	/* coordinator side, job sent to result received, so it includes transfer */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Bake")
+		float busyMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Bake")
+		float pixelsPerSecond = 0;
+};
+
+struct FLanGenBakeJob
+{
+	int32 tile = 0;
+	int32 x0 = 0, y0 = 0, x = 0, y = 0;
+	FLanGenBakeNoise noise;
+
+	friend FArchive& operator<<(FArchive& ar, FLanGenBakeJob& in);
+};
+
+struct FLanGenBakeResult
+{
+	int32 tile = 0;
+	float computeMs = 0;
+	/* job x * y, same layout as the map */
+	TArray<float> heights;
+
+	friend FArchive& operator<<(FArchive& ar, FLanGenBakeResult& in);
+};
+
+/**
+ * Framed messages over one stream socket.
+ * Sends block until the whole frame is out or their deadline passes; receives never block and hand out complete frames only.
+ */
+struct LANSCAPEGENERATION_API FLanGenBakeChannel
+{
+	/* refuse frames above this, a corrupt length must not allocate gigabytes */
+	static const uint32 MAX_PAYLOAD = 512 * 1024 * 1024;
+
+	FSocket* socket = nullptr;
+	bool isBroken = false;
+
+	FLanGenBakeChannel(FSocket* inSocket = nullptr) : socket(inSocket) {}
+
+	/* false with isBroken set when the peer is gone or hasn't taken the frame within seconds */
+	bool Send(LanGenBakeMessage::Type type, const TArray<uint8>& payload = TArray<uint8>(), float seconds = 30);
+	/* true when a whole frame was taken from the socket; false with isBroken set on a dead or corrupt stream */
+	bool Receive(LanGenBakeMessage::Type& type, TArray<uint8>& payload);
+	/* blocks up to seconds for the next frame */
+	bool Wait(LanGenBakeMessage::Type& type, TArray<uint8>& payload, float seconds);
+	void Close();
+private:
+	TArray<uint8> inbox;
+};
+
+/* payload helpers */
+template <typename T> TArray<uint8> LanGenBakePack(T& in)
+{
+	TArray<uint8> res;
+	FMemoryWriter writer(res);
+	writer << in;
+	return res;
+}
+
+template <typename T> bool LanGenBakeUnpack(const TArray<uint8>& payload, T& out)
+{
+	FMemoryReader reader(payload);
+	reader << out;
+	return !reader.IsError();
+}
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "LanGenBakeProtocol.h"
+#include "LanGenBakeWorker.generated.h"
+
+class ULanGenNoiseObject;
+
+/* worker side of ULanGenBakeCoordinator, run headless through ULanGenBakeCommandlet */
+UCLASS()
+class LANSCAPEGENERATION_API ULanGenBakeWorker : public UObject
+{
+	GENERATED_BODY()
+public:
+	/* seconds to keep trying the coordinator's port before giving up */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float connectTimeout = 30;
+	/* seconds without a word from the coordinator before the worker gives up on it; keep above the coordinator's jobTimeout */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Bake")
+		float idleTimeout = 300;
+private:
+	UPROPERTY(Transient)
+		ULanGenNoiseObject* noise = nullptr;
+public:
+	/* serves jobs until the coordinator says quit (true) or the link drops or goes silent (false); host is an IPv4 address, empty for loopback */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Bake")
+		bool Run(const FString& host, int32 port, int32 id);
+private:
+	bool Bake(const FLanGenBakeJob& job, FLanGenBakeResult& out);
+};
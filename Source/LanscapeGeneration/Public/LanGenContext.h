@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "Math/Color.h"
+#include "Templates/SharedPointer.h"
+
+struct FLanGenTurtleProgram;
+
+/* everything a compiled grammar depends on; rules compare case sensitive, F and f are different symbols */
+struct LANSCAPEGENERATION_API FLanGenProgramKey
+{
+	int32 seed = 0, ruleLoop = 0, minAngle = 0, maxAngle = 0;
+	FString rule, axiom;
+
+	bool operator==(const FLanGenProgramKey& other) const
+	{
+		return seed == other.seed && ruleLoop == other.ruleLoop && minAngle == other.minAngle && maxAngle == other.maxAngle
+			&& rule.Equals(other.rule, ESearchCase::CaseSensitive) && axiom.Equals(other.axiom, ESearchCase::CaseSensitive);
+	}
+};
+
+/**
+ * Generation state that outlives a single widget run, owned by FLanscapeGenerationModule.
+ * Shared objects keep their buffers between runs, permutation tables and compiled grammars are built once per seed,
+ * and height buffers are pooled per size so switching between preview and full size does not reallocate.
+ * Game thread only, like the objects it hands out.
+ */
+class LANSCAPEGENERATION_API FLanGenContext : public FGCObject
+{
+public:
+	/* seeds kept per table kind, compiled grammars and pooled buffers kept at once; the oldest goes first */
+	static const int MAX_SEEDS = 64, MAX_PROGRAMS = 4, MAX_BUFFERS = 8;
+
+	static FLanGenContext& Get();
+
+	/* one instance per class for the whole session, outered to the transient package */
+	UObject* Shared(UClass* type);
+	template <typename T> T* Shared() { return CastChecked<T>(Shared(T::StaticClass())); }
+
+	/* 512 entry table for seed, build fills it the first time; copy it out, the reference lasts until the next call */
+	const TArray<int>& Permutation(FName kind, int32 seed, TFunctionRef<void(TArray<int>&)> build);
+
+	/* null on a miss; a hit becomes the most recent */
+	TSharedPtr<FLanGenTurtleProgram> FindProgram(const FLanGenProgramKey& key);
+	void AddProgram(const FLanGenProgramKey& key, const TSharedRef<FLanGenTurtleProgram>& program);
+
+	/*
+	* parks inOut under (name, oldSize) and hands back what was parked under (name, newSize), empty if nothing;
+	* moves only, so a size seen before comes back with its allocation
+	*/
+	void SwapBuffer(FName name, FIntPoint oldSize, FIntPoint newSize, TArray<FColor>& inOut);
+
+	/* drops every cache and shared object */
+	void Release();
+
+	virtual void AddReferencedObjects(FReferenceCollector& collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FLanGenContext"); }
+private:
+	struct programEntry {
+		FLanGenProgramKey key;
+		TSharedRef<FLanGenTurtleProgram> program;
+	};
+	struct bufferEntry {
+		FName name;
+		FIntPoint size;
+		TArray<FColor> data;
+	};
+
+	TMap<UClass*, UObject*> shared;
+	/* per kind, oldest seed first */
+	TMap<FName, TArray<TPair<int32, TArray<int>>>> permutations;
+	/* oldest first */
+	TArray<programEntry> programs;
+	TArray<bufferEntry> buffers;
+};
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Math/Color.h"
+#include "LanGenStats.h"
+#include "LanGenDerivedLayerObject.generated.h"
+
+class ULanGenNoiseObject;
+class ULandscapeLayerInfoObject;
+class ALandscapeProxy;
+
+/* one weightmap; weight = height band * slope band, optionally noise modulated */
+USTRUCT(BlueprintType)
+struct LANSCAPEGENERATION_API FLanGenWeightLayer
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		ULandscapeLayerInfoObject* layerInfo = nullptr;
+	/* heightmap units, same scale as the R channel */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float minHeight = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float maxHeight = 255;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float heightBlend = 8;
+	/* degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float minSlope = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float maxSlope = 90;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float slopeBlend = 5;
+	/* 0 = no noise; 1 = weight swings by the full noise range */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float noiseAmount = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float noiseScale = 0.02;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		float strength = 1;
+};
+
+/**
+ * Normals, slope, curvature and weightmaps from a heightmap in one pass.
+ * Rows are processed in blocks so the three rows a pixel needs stay in cache;
+ * each row gets a derivative loop, then one weight loop per layer.
+ */
+UCLASS(BlueprintType)
+class LANSCAPEGENERATION_API ULanGenDerivedLayerObject : public UObject
+{
+	GENERATED_BODY()
+public:
+	static const int BLOCK_ROWS = 16;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		TArray<FLanGenWeightLayer> layers;
+	/* weights of all layers add up to 255 where any layer is present */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Layer")
+		bool normalizeWeights = true;
+private:
+	int lanX = 0, lanY = 0;
+	TArray<FColor> normalMap;
+	TArray<float> slope, curvature;
+	/* layer after layer, lanX * lanY each */
+	TArray<uint8> weights;
+	FLanGenStats stats;
+public:
+	/*
+	* heightScale = world height of one R step / world size of one pixel
+	* noise is optional and must be seeded
+	*/
+	UFUNCTION(BlueprintCallable, Category = "LanGen Layer")
+		void Compute(const TArray<FColor>& heightmap, int x, int y, float heightScale = 1, ULanGenNoiseObject* noise = nullptr);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Layer")
+		bool WriteToLandscape(ALandscapeProxy* landscape, FIntPoint offset);
+
+	UFUNCTION(BlueprintCallable, Category = "LanGen Layer")
+		TArray<FColor> GetNormalMap() const { return normalMap; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Layer")
+		TArray<float> GetSlope() const { return slope; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Layer")
+		TArray<float> GetCurvature() const { return curvature; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Layer")
+		TArray<uint8> GetWeightLayer(int layer) const;
+	UFUNCTION(BlueprintCallable, Category = "LanGen Layer")
+		FLanGenStats GetLastStats() const { return stats; }
+
+	const TArray<float>& SlopeView() const { return slope; }
+	const TArray<uint8>& WeightView() const { return weights; }
+	int GetLayerStride() const { return lanX * lanY; }
+
+	/* 1 inside [min, max], fading to 0 over blend outside of it */
+	static float Band(float value, float min, float max, float blend);
+};
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+
+/**
+ * Exact euclidean nearest seed transform (Felzenszwalb & Huttenlocher), two separable passes.
+ * Grids use the plugin layout: index = x * yLen + y
+ */
+struct LANSCAPEGENERATION_API FLanGenDistanceField
+{
+	/*
+	* in: seed pixels hold their own index, everything else INDEX_NONE
+	* out: every pixel holds the index of its nearest seed, INDEX_NONE if there is no seed at all
+	* parallel splits both passes over the task graph; the result is identical either way
+	*/
+	static void NearestSeed(TArrayView<int32> nearest, int xLen, int yLen, bool parallel = false);
+	/*
+	* same in and out, but the winner minimises |p - s|^2 - radius[s]^2 (power diagram) instead of |p - s|;
+	* radius is read at seed pixels only. a pixel inside any seed's radius is inside its winner's, and of
+	* overlapping seeds the one covering it deepest relative to its size wins
+	*/
+	static void NearestPowerSeed(TArrayView<int32> nearest, TArrayView<const int32> radius, int xLen, int yLen, bool parallel = false);
+};
+
+/**
+ * The same transform over a sparse set of BLOCK x BLOCK blocks, for strokes whose bounds are mostly empty.
+ * Uncovered pixels are never read or written and act as walls, so a pixel gets its true nearest seed whenever
+ * the x then y path from it to that seed stays covered; covering the square each seed reaches guarantees it.
+ * Arrays live on the mem stack, same rules as coordArray.
+ */
+struct LANSCAPEGENERATION_API FLanGenSparseField
+{
+	static const int BLOCK = 16, AREA = BLOCK * BLOCK;
+
+	/* block coords; sorted by x then y once built */
+	TArray<FIntPoint, TMemStackAllocator<>> blocks;
+	/* AREA per block in plugin layout: seed id in, nearest seed id out, INDEX_NONE for none */
+	TArray<int32, TMemStackAllocator<>> nearest;
+
+	/* covers every block overlapping the inclusive rect; before Build */
+	void AddRect(int x0, int y0, int x1, int y1);
+	/* sorts, drops duplicate blocks and clears every pixel to INDEX_NONE */
+	void Build();
+	/* nearest index of the pixel, INDEX_NONE when it is not covered */
+	int Find(int x, int y) const;
+	/* fills nearest for every covered pixel */
+	void Resolve();
+
+	static int BlockOf(int in) { return in >= 0 ? in / BLOCK : (in - BLOCK + 1) / BLOCK; }
+private:
+	FIntRect lastRect = FIntRect(0, 0, -1, -1);
+};
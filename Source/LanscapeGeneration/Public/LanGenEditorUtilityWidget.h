@@ -5,8 +5,11 @@
 #include "CoreMinimal.h"
 #include "EditorUtilityWidget.h"
 #include "Math/Color.h"
+#include "LanGenStats.h"
 #include "LanGenEditorUtilityWidget.generated.h"
 
+class ULanGenPreviewTextureManager;
+
 /**
  * 
  */
@@ -16,6 +19,9 @@ class LANSCAPEGENERATION_API ULanGenEditorUtilityWidget : public UEditorUtilityW
 	GENERATED_BODY()
 protected:
 	uint8 NoiseToColor(float in);
+	FLanGenStats stats;
+	UPROPERTY(Transient)
+		ULanGenPreviewTextureManager* previewTextures = nullptr;
 
 public:
 	UFUNCTION(BlueprintCallable)
@@ -24,6 +30,21 @@ public:
 		static void ScrLog(FString text);
 	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
 		UTexture2D* GenerateTexture(int x, int y, int tileX = 512, int tileY = 512, int generateParam = 0);
+	/* noise and upload of the last GenerateTexture; the elevation map's share is in the elevation object's stats */
+	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
+		FLanGenStats GetLastStats() const { return stats; }
+	/* one long lived instance per class, kept by the module between runs; use instead of constructing objects per run */
+	UFUNCTION(BlueprintCallable, Category = "Landscape Generation", meta = (DeterminesOutputType = "type"))
+		static UObject* SharedObject(TSubclassOf<UObject> type);
+	/* frees the shared objects, pooled buffers and cached tables and grammars */
+	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
+		static void ReleaseSharedState();
+	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
+		static FLanGenStats CombineStats(const FLanGenStats& a, const FLanGenStats& b);
+	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
+		static FString StatsToString(const FLanGenStats& in) { return in.ToString(); }
+	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
+		static void LogStats(const FLanGenStats& in) { ConLog(in.ToString()); }
 	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
 		uint8 MapTo8Bit(float in, float min = -1.0, float max = 1.0);
 	UFUNCTION(BlueprintCallable, Category = "Landscape Generation")
@@ -5,6 +5,11 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "Math/Color.h"
+#include "Misc/MemStack.h"
+#include "LanGenStats.h"
+#include "LanGenRandom.h"
+#include "LanGenHeightPyramid.h"
+#include "LanGenTurtleProgram.h"
 #include "LanGenElevationObject.generated.h"
 
 struct rule {
@@ -19,9 +24,9 @@ struct coord {
 	coord(int X, int Y, int THETA) { x = X, y = Y, theta = THETA, height = 0; }
 	void SetTheta(int value) { theta = Mod(value); }
 	void AddTheta(int value) { theta = Mod(theta + value); }
-	int AddThetaTemp(int value) { return (theta + value) % 360; }
-	int index(int yLen) { return x * yLen + y; }
-	bool isInRange(int xLen, int yLen) { return x >= 0 && y >= 0 && x < xLen&& y < yLen; }
+	int AddThetaTemp(int value) const { return (theta + value) % 360; }
+	int index(int yLen) const { return x * yLen + y; }
+	bool isInRange(int xLen, int yLen) const { return x >= 0 && y >= 0 && x < xLen&& y < yLen; }
 	static int Mod(int in) {
 		int tempInt = in % 360;
 		if (tempInt < 0) tempInt += 360;
@@ -29,23 +34,85 @@ struct coord {
 	}
 };
 
+/*
+* per generation scratch; lives on FMemStack until the FMemMark that was open when it grew pops,
+* so do not grow an outer array while a nested mark is open
+*/
+typedef TArray<coord, TMemStackAllocator<>> coordArray;
+
+/*
+* ridge polyline, one stream per field so the per point loops only pull what they use;
+* same arena rules as coordArray. positions saturate at int16, far outside any landscape
+*/
+struct coordStream {
+	TArray<int16, TMemStackAllocator<>> x, y;
+	TArray<uint16, TMemStackAllocator<>> theta;
+	TArray<int32, TMemStackAllocator<>> height;
+
+	int Num() const { return x.Num(); }
+	int Last() const { return x.Num() - 1; }
+	void Reserve(int num) { x.Reserve(num), y.Reserve(num), theta.Reserve(num), height.Reserve(num); }
+	void Reset() { x.Reset(), y.Reset(), theta.Reset(), height.Reset(); }
+	void Add(const coord& in) { x.Add(Narrow(in.x)), y.Add(Narrow(in.y)), theta.Add(in.theta), height.Add(in.height); }
+	coord Get(int i) const {
+		coord res(x[i], y[i], theta[i]);
+		res.height = height[i];
+		return res;
+	}
+	static int16 Narrow(int in) { return FMath::Clamp(in, (int)MIN_int16, (int)MAX_int16); }
+};
+
 struct midPoint {
 	int index, height;
 	midPoint() { index = 0, height = 0; }
 	midPoint(int x, int y) { index = x, height = y; }
 };
 
+/* per ridge point falloff parameters, see GradientSingleMainHelper */
+struct falloff {
+	int height, theta, leftRadius, rightRadius,
+		blendLeftHeight, blendRightHeight, blendLeftOffset, blendRightOffset,
+		topBlendLeftStart, topBlendRightStart, topBlendPeakOffset, topBlendPeak,
+		topBlendLeftOffset, topBlendRightOffset;
+	float leftA, rightA, blendLeftA, blendRightA, topBlendA;
+};
+
+/* ridge point waiting for the distance field pass */
+struct ridgeSeed {
+	int x, y, fillDegree;
+	falloff profile;
+};
+
+UENUM(BlueprintType)
+enum class ELanGenRidgeRaster : uint8 {
+	/* stamp a full footprint around every ridge point, max wins; the reference output */
+	Splat UMETA(DisplayName = "Per Point Splat"),
+	/*
+	* evaluate the falloff once per pixel against the closest ridge point, cut off at that point's radius;
+	* an approximation of Splat, which takes the max over every stamp whose box covers the pixel
+	*/
+	Sweep UMETA(DisplayName = "Swept Stroke"),
+	/* collect every ridge first, then one multithreaded pass over the whole map against the ridge point weighted by footprint */
+	DistanceField UMETA(DisplayName = "Distance Field"),
+};
+
 UCLASS(BlueprintType)
 class LANSCAPEGENERATION_API ULanGenElevationObject : public UObject
 {
 	GENERATED_BODY()
 public:
 	int32 seed;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Elevation")
+		ELanGenRidgeRaster ridgeRaster = ELanGenRidgeRaster::Splat;
 private:
-	FRandomStream randomEngine;
+	FLanGenRandom random;
+	uint64 coordDraws = 0;
 	TArray<rule> rules;
 	TArray<int> p;
 	TArray<FColor> texture, detailTexture;
+	TArray<ridgeSeed> mainSeeds, detailSeeds;
+	/* main ridge pixels of the last generation, for stages that follow the ridges */
+	TArray<FIntPoint> ridgePoints;
 	const TArray<int> P_BASE = {
 		151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,
 		8,99,37,240,21,10,23,190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,
@@ -61,7 +128,12 @@ private:
 		138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
 	};
 	FColor init;
-	int lanX, lanY;
+	int lanX = 0, lanY = 0;
+	/* lowest drawn height per block of texture / detailTexture; a stamp that can't beat it is skipped */
+	FLanGenHeightPyramid mainPyramid, detailPyramid;
+	/* program of the last generation, shared with the context's cache */
+	TSharedPtr<FLanGenTurtleProgram> program;
+	FLanGenStats stats;
 public:
 	UFUNCTION(BlueprintCallable, Category = "LanGen Elevation")
 		void ResetSeed();
@@ -71,6 +143,7 @@ public:
 		FVector2D RandomizeCoord(float percentageSafeZone);
 	UFUNCTION(BlueprintCallable, Category = "LanGen Elevation")
 		FVector2D CenterTerrainCoord();
+	/* Blueprint gets its own copy of the result; native callers use Generate and TextureView */
 	UFUNCTION(BlueprintCallable, Category = "LanGen Elevation")
 		TArray<FColor> GenerateGraph(
 			FVector2D startingPosition, FString rule, FString axiom,
@@ -81,16 +154,41 @@ public:
 		);
 	UFUNCTION(BlueprintCallable, Category = "LanGen Elevation")
 		TArray<FColor> CombineTexture(TArray<FColor> texture1, TArray<FColor> texture2);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Elevation")
+		FLanGenStats GetLastStats() const { return stats; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Elevation")
+		TArray<FIntPoint> GetRidgePoints() const { return ridgePoints; }
+	const TArray<FIntPoint>& RidgePointsView() const { return ridgePoints; }
+	/* same as GenerateGraph without copying the result out; it stays in TextureView until the next run or Init */
+	void Generate(
+		FVector2D startingPosition, const FString& rule, const FString& axiom,
+		int ruleLoop, int lineLength = 3, int minAngle = 30,
+		int maxAngle = 30, int radius = 50, int peak = 50,
+		float skew = 0, int fillDegree = 90, float topBlend = 0.1,
+		int disLoop = 5, float disSmooth = 1.1, int startHeight = 50
+	);
+	const TArray<FColor>& TextureView() const { return texture; }
 private:
 	void RuleSetup(FString rule);
 	FString RuleApply(FString axiom, int loop);
 	void Shuffle(TArray<int>& inArr);
-	FString RandomizeRule(int ruleIndex, FString& last);
-	void Bresenham(TArray<coord>& currentLine, int lineLength);
-	void MidpointDisplacement(TArray<coord>& currentLine, int peak, int peakIndex, int displacement, int loop, float smooth = 1.1);
+	void RandomizeRule(int ruleIndex, uint64 key, FString& out, FString& last);
+	void Bresenham(coordStream& currentLine, int lineLength, int steps = 1);
+	void MidpointDisplacement(coordStream& currentLine, uint32 strokeIndex, int peak, int peakIndex, int displacement, int loop, float smooth = 1.1);
+	int MidpointCount(int length, int loop);
+	void MidpointSpan(int32* heights, midPoint first, midPoint last, float linearM, int peakIndex, int peak, int loop, int displacement, float modifier, const int32* signs);
+	static int LerpHeight(midPoint a, midPoint b, int index);
+	static void LerpSpan(int32* RESTRICT out, int length, int startHeight, int endHeight);
 
-	void GradientSingleMain(TArray<coord>& curLine, int peak, int radius, float skew, int fillDegree, float topBlend, bool calcHeight = true, bool isAdd = false);
+	void GradientSingleMain(coordStream& curLine, int peak, int radius, float skew, int fillDegree, float topBlend, bool calcHeight = true, bool isAdd = false);
 	void GradientSingleMainHelper(coord curCoord, int radius, float skew, int fillDegree, float topBlend, bool isAdd = false);
+	void GradientSweep(const coordStream& curLine, float m, float skew, int fillDegree, float topBlend, bool isAdd = false);
+	falloff MakeFalloff(const coord& curCoord, int radius, float skew, float topBlend);
+	/* upper bound of every height FalloffHeight can return for f */
+	static int FalloffPeak(const falloff& f);
+	bool FalloffHeight(const falloff& f, int x, int y, int fillDegree, int& height);
+	void SeedRidge(const coordStream& curLine, float m, float skew, int fillDegree, float topBlend, bool isAdd = false);
+	void ResolveRidgeField(TArray<ridgeSeed>& seeds, bool isAdd = false);
 
 	float EuclideanDistance(coord pointCoord, coord centerCoord = coord());
 	int Parabola(float a, float c, float x, float xOffset = 0);
@@ -102,8 +200,9 @@ private:
 	float LinearM(float c, float xMax, float modifier = -1);
 	float LinearX(float m, float c, float y);
 
-	void Draw(TArray<coord> currentLine, bool overwrite = false);
-	void DrawDetail(TArray<coord> currentLine, bool overwrite = false);
+	void Draw(TArrayView<const coord> currentLine, bool overwrite = false);
+	void DrawDetail(TArrayView<const coord> currentLine, bool overwrite = false);
+	void DrawPixel(int index, int height, bool isAdd);
 	static float DegreeToRad(int degree);
 	static float RadToDegree(float rad);
 	static int Abs(int in);
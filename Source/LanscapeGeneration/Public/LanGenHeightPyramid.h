@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Color.h"
+
+/**
+ * Two level minimum height pyramid over the R channel of a texture that is only ever raised.
+ * A block turns dirty when a pixel in it is written and is rescanned the next time it is asked for,
+ * so drawing stays a flag store and only blocks that are queried pay for the rescan.
+ */
+struct LANSCAPEGENERATION_API FLanGenHeightPyramid
+{
+	/* pixels per block side, blocks per super block side */
+	static const int BLOCK = 16, FAN = 4;
+
+	/* height = R - bias */
+	void Init(const TArray<FColor>& inSource, int x, int y, int bias);
+	void MarkWritten(int x, int y)
+	{
+		int bx = x / BLOCK, by = y / BLOCK;
+		blockDirty[bx * blocksY + by] = 1;
+		superDirty[bx / FAN * superY + by / FAN] = 1;
+	}
+	void MarkAllWritten();
+
+	/* lowest height in the blocks covering the inclusive rect; MAX_int32 when it is off the map */
+	int RegionMin(int x0, int y0, int x1, int y1);
+	/* nothing up to peak can be drawn at this pixel */
+	bool IsOccluded(int x, int y, int peak)
+	{
+		return x < 0 || y < 0 || x >= lanX || y >= lanY || BlockMin(x / BLOCK, y / BLOCK) >= peak;
+	}
+private:
+	const TArray<FColor>* source = nullptr;
+	int lanX = 0, lanY = 0, bias = 0, blocksX = 0, blocksY = 0, superX = 0, superY = 0;
+	TArray<int16> blockMin, superMin;
+	TArray<uint8> blockDirty, superDirty;
+
+	int BlockMin(int bx, int by);
+	int SuperMin(int sx, int sy);
+};
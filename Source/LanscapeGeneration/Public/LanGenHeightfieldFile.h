@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Math/Color.h"
+#include "Templates/UniquePtr.h"
+#include "LanGenStats.h"
+#include "LanGenHeightfieldFile.generated.h"
+
+UENUM(BlueprintType)
+enum class ELanGenHeightCodec : uint8 {
+	Raw UMETA(DisplayName = "Uncompressed"),
+	LZ4 UMETA(DisplayName = "LZ4"),
+	/* only where the engine ships the Oodle data compressor; tiles fall back to raw otherwise */
+	Oodle UMETA(DisplayName = "Oodle"),
+};
+
+/**
+ * Tiled compressed heightfield on disk: header | tile index | tile blobs.
+ * Every tile is quantized to 16 bit against its own min and step, predicted from its left,
+ * up and up-left neighbours, and the residual byte planes go through the codec.
+ * The index gives random access to any tile; tiles are encoded and decoded in parallel
+ * batches so neither side holds more than a batch of packed tiles.
+ */
+UCLASS(BlueprintType)
+class LANSCAPEGENERATION_API ULanGenHeightfieldFile : public UObject
+{
+	GENERATED_BODY()
+public:
+	/* "LGHF" */
+	static const uint32 MAGIC = 0x4648474C;
+	static const uint32 VERSION = 1;
+	static const int TILE = 256;
+	/* tiles in flight per parallel encode / decode */
+	static const int BATCH = 64;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Heightfield")
+		ELanGenHeightCodec codec = ELanGenHeightCodec::LZ4;
+	/* quantization step of float heights, error is at most half of it; coarser where a tile spans more than 65535 steps */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Heightfield")
+		float precision = 0.01;
+	/* file bytes of the last write */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Heightfield")
+		int64 lastFileBytes = 0;
+private:
+	struct fileHeader { uint32 magic, version; int32 sizeX, sizeY, tile, flags; };
+	/* height = base + q * step */
+	struct tileEntry { uint64 offset; uint32 packedSize; uint8 codec, pad[3]; float base, step; };
+
+	TUniquePtr<FArchive> reader;
+	int64 readerSize = 0;
+	int lanX = 0, lanY = 0, tileSize = TILE, tilesX = 0, tilesY = 0;
+	TArray<tileEntry> index;
+	FLanGenStats stats;
+public:
+	/* R channel, lossless */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		bool WriteHeightmap(const FString& path, const TArray<FColor>& heightmap, int x, int y);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		bool WriteHeights(const FString& path, const TArray<float>& heights, int x, int y);
+
+	/* reads the header and index only; tiles are read on demand */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		bool Open(const FString& path);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		void Close();
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		bool IsOpen() const { return reader.IsValid(); }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		FIntPoint GetSize() const { return FIntPoint(lanX, lanY); }
+	/* x * y heights from (x0, y0), decoding only the tiles the rect touches; empty when it leaves the map */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		TArray<float> ReadRegion(int x0, int y0, int x, int y);
+	/* whole map back into the R channel */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		TArray<FColor> ReadHeightmap();
+
+	UFUNCTION(BlueprintCallable, Category = "LanGen Heightfield")
+		FLanGenStats GetLastStats() const { return stats; }
+private:
+	template <typename Func> bool WriteTiles(const FString& path, int x, int y, bool exact, Func sample);
+	/* store(x, y, height) for every pixel of the half open rect */
+	template <typename Func> bool ReadTiles(int x0, int y0, int x1, int y1, Func store);
+
+	static void EncodeTile(const uint16* q, int w, int h, ELanGenHeightCodec inCodec, TArray<uint8>& out, uint8& outCodec);
+	static bool DecodeTile(const uint8* in, int32 size, uint8 inCodec, int w, int h, uint16* q);
+	/* median edge predictor; the first row and column predict from their single neighbour */
+	static uint16 Predict(const uint16* q, int x, int y, int h);
+	static FName FormatName(uint8 inCodec);
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Math/Color.h"
+#include "LanGenStats.h"
+#include "LanGenHydrologyObject.generated.h"
+
+UENUM(BlueprintType)
+enum class ELanGenFlowRouting : uint8 {
+	/* all flow to the steepest of the 8 neighbours */
+	D8 UMETA(DisplayName = "D8"),
+	/* flow split between the two neighbours of the steepest facet */
+	DInfinity UMETA(DisplayName = "D Infinity"),
+};
+
+/**
+ * Drainage on the R channel heightmap: priority flood depression filling, flow routing,
+ * flow accumulation and river carving.
+ * Tiles flood on their own from their perimeter; only the small graph of where tile
+ * watersheds meet is solved for the whole map.
+ * Results are kept between runs; a rerun only floods the changed tiles and routes,
+ * accumulates and carves the tiles the change can reach.
+ */
+UCLASS(BlueprintType)
+class LANSCAPEGENERATION_API ULanGenHydrologyObject : public UObject
+{
+	GENERATED_BODY()
+public:
+	static const int TILE = 256;
+	/* R channel heights */
+	static const int LEVELS = 256;
+	static const uint8 NO_FLOW = 8;
+	static const uint16 NO_SPILL = MAX_uint16;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Hydrology")
+		ELanGenFlowRouting routing = ELanGenFlowRouting::D8;
+	/* carve into the filled surface instead of the input, pits become lakes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Hydrology")
+		bool fillDepressions = true;
+	/* upstream cells before a channel is cut */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Hydrology")
+		float riverThreshold = 2000;
+	/* channel depth = carveScale * sqrt(accumulation - riverThreshold) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Hydrology")
+		float carveScale = 0.05;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Hydrology")
+		int maxCarveDepth = 12;
+	/* tiles carved by the last run */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Hydrology")
+		int lastDirtyTiles = 0;
+private:
+	/* two tile perimeter watersheds meet at weight */
+	struct spillEdge { int32 a, b; uint16 weight; };
+
+	int lanX = 0, lanY = 0, tilesX = 0, tilesY = 0, labelCount = 0;
+	ELanGenFlowRouting routedWith = ELanGenFlowRouting::D8;
+	uint32 carvedWith = 0;
+	bool isValid = false;
+
+	TArray<uint16> height, localFilled, filled;
+	/* tile perimeter cell each cell was flooded from, numbered from labelBase of its tile */
+	TArray<int32> label, labelBase;
+	TArray<TArray<spillEdge>> tileEdges;
+	/* lowest level a watershed can drain off the map at */
+	TArray<uint16> spill;
+	/* receiver directions, share of the first one out of 255 */
+	TArray<uint8> receiver, receiver2, share;
+	TArray<float> accumulation;
+	TArray<FColor> carved;
+
+	/* scratch kept between runs */
+	TArray<int8> donorCount;
+	TArray<uint8> accDirty, inputTiles, fillTiles, routeTiles, accTiles;
+	TArray<TArray<int32>> tileSeeds, tileFlats;
+	FLanGenStats stats;
+public:
+	/* returns false when nothing changed since the last run */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Hydrology")
+		bool Run(const TArray<FColor>& heightmap, int x, int y);
+	/* next run recomputes every tile */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Hydrology")
+		void Invalidate() { isValid = false; }
+
+	UFUNCTION(BlueprintCallable, Category = "LanGen Hydrology")
+		TArray<FColor> GetCarvedHeightmap() const { return carved; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Hydrology")
+		TArray<float> GetAccumulation() const { return accumulation; }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Hydrology")
+		FLanGenStats GetLastStats() const { return stats; }
+private:
+	void Flood(bool full);
+	void FloodTile(int32 tile);
+	void ResolveSpill();
+	void Route(bool full);
+	void ResolveFlats(bool full);
+	void MarkDownstream(bool full);
+	void Accumulate();
+	void Carve(bool full);
+
+	void RouteD8(int x, int y, uint8& out) const;
+	void RouteDInfinity(int x, int y, uint8& out, uint8& out2, uint8& outShare) const;
+	/* fraction of from's flow that goes to the neighbour in direction dir */
+	float ShareTo(int32 from, uint8 dir) const;
+	/* no lower neighbour on the filled surface and not on the map border */
+	bool IsFlat(int32 index) const;
+
+	int TileOf(int32 index) const { return (index / lanY / TILE) * tilesY + (index % lanY) / TILE; }
+	template <typename Func> void ForTile(int32 tile, Func func) const;
+	static uint8 Opposite(uint8 dir) { return (dir + 4) & 7; }
+};
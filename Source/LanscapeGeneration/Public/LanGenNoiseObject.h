@@ -4,8 +4,37 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "Misc/MemStack.h"
+#include "LanGenStats.h"
 #include "LanGenNoiseObject.generated.h"
 
+UENUM(BlueprintType)
+enum class ELanGenNoiseType : uint8 {
+	Perlin UMETA(DisplayName = "Perlin"),
+	Simplex UMETA(DisplayName = "Simplex"),
+};
+
+/* adaptive fBm field against the full resolution one */
+USTRUCT(BlueprintType)
+struct LANSCAPEGENERATION_API FLanGenNoiseBenchmark
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Noise")
+		float exactMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Noise")
+		float adaptiveMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Noise")
+		int64 exactSamples = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Noise")
+		int64 adaptiveSamples = 0;
+	/* largest absolute difference over the map, in noise units */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Noise")
+		float maxError = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Noise")
+		float rmsError = 0;
+};
+
 /**
  * 
  */
@@ -16,7 +45,22 @@ class LANSCAPEGENERATION_API ULanGenNoiseObject : public UObject
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Noise")
 		int32 seed;
+	/*
+	* adaptive fields sample each octave at 2 * nyquistMargin points per lattice cell and upsample;
+	* 3 keeps the error of a unit amplitude field around 0.01
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Noise")
+		float nyquistMargin = 3;
+	/* catmull-rom upsampling, bilinear otherwise; cubic is about 4 times more accurate at the same cost */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Noise")
+		bool cubicUpsample = true;
 private:
+	/* output pixel reads coarse samples k .. k + 3 */
+	struct upsampleTap {
+		int32 k;
+		float w[4];
+	};
+
 	TArray<int> p;
 	const TArray<int> P_BASE = {
 		151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,
@@ -33,6 +77,7 @@ private:
 		138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
 	};
 	FRandomStream randomEngine;
+	FLanGenStats stats;
 public:
 	UFUNCTION(BlueprintCallable, Category = "LanGen Noise")
 		void ResetSeed();
@@ -42,7 +87,30 @@ public:
 		float PerlinNoise3D(FVector location, int n, float lacunarity = 2, float persistence = 0.5, float in = 0.0);
 	UFUNCTION(BlueprintCallable, Category = "LanGen Noise")
 		float SimplexNoise3D(FVector location, int n, float lacunarity = 2, float persistence = 0.5, float in = 0.0);
+	/*
+	* x * y map of octaves 0 .. octaves - 1 summed, pixel (i, j) at location (i / tileX, j / tileY, z);
+	* adaptive evaluates low octaves on coarser grids, see nyquistMargin
+	*/
+	UFUNCTION(BlueprintCallable, Category = "LanGen Noise")
+		TArray<float> FbmField(int x, int y, float tileX, float tileY, int octaves, ELanGenNoiseType type = ELanGenNoiseType::Perlin,
+			float lacunarity = 2, float persistence = 0.5, float z = 0, bool adaptive = true);
+	/* x * y part of the field from pixel (x0, y0); coarse grids stay on map multiples, so regions match the whole field exactly */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Noise")
+		TArray<float> FbmRegion(int x0, int y0, int x, int y, float tileX, float tileY, int octaves, ELanGenNoiseType type = ELanGenNoiseType::Perlin,
+			float lacunarity = 2, float persistence = 0.5, float z = 0, bool adaptive = true);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Noise")
+		FLanGenNoiseBenchmark BenchmarkFbmField(int x, int y, float tileX, float tileY, int octaves, ELanGenNoiseType type = ELanGenNoiseType::Perlin,
+			float lacunarity = 2, float persistence = 0.5, float z = 0);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Noise")
+		FLanGenStats GetLastStats() const { return stats; }
+	bool IsSeeded() const { return p.Num() == 512; }
 private:
+	float Octave(ELanGenNoiseType type, float x, float y, float z, int n, float lacunarity, float persistence);
+	/* coarse grid spacing in pixels for an octave whose lattice cell is cellPixels wide */
+	int OctaveSpacing(float cellPixels) const;
+	/* taps for pixels first .. first + num - 1, relative to the coarse sample before first / spacing */
+	void UpsampleTaps(int first, int num, int spacing, TArray<upsampleTap, TMemStackAllocator<>>& out) const;
+
 	float Fade(float t);
 	float Lerp(float t, float a, float b);
 	float Grad(int hash, float x, float y, float z);
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Math/Color.h"
+#include "LanGenPreviewTextureManager.generated.h"
+
+class UTexture2D;
+
+/**
+ * One transient uncompressed G16 texture per preview size, refreshed in place.
+ * Only the row bands whose pixels changed since the last upload are sent to the GPU.
+ */
+UCLASS()
+class LANSCAPEGENERATION_API ULanGenPreviewTextureManager : public UObject
+{
+	GENERATED_BODY()
+public:
+	/* rows per dirty band; each band uploads at most one rectangle */
+	static const int BAND_HEIGHT = 64;
+
+	UFUNCTION(BlueprintCallable, Category = "LanGen Preview")
+		UTexture2D* Update(int x, int y, const TArray<FColor>& colorData);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Preview")
+		void Release();
+
+	/* pixels sent by the last Update */
+	int64 lastUploadPixels = 0;
+private:
+	UPROPERTY(Transient)
+		TMap<FIntPoint, UTexture2D*> textures;
+	/* what the GPU currently holds per size */
+	TMap<FIntPoint, TArray<uint16>> uploaded;
+
+	UTexture2D* FindOrCreate(int x, int y);
+	void UploadRect(UTexture2D* texture, const TArray<uint16>& src, int x, int minX, int minY, int maxX, int maxY);
+};
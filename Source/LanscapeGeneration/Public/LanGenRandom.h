@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* independent random streams; a value is only ever keyed inside its own stream */
+namespace LanGenStream
+{
+	enum Type : uint32
+	{
+		Shuffle,
+		Rule,
+		Turtle,
+		Displacement,
+		Coord,
+		Scatter,
+	};
+}
+
+/**
+ * Stateless counter based generator (SplitMix64 finalizer over seed, stream and index).
+ * A draw depends only on its key, never on how many draws came before it,
+ * so serial, parallel, tiled and incremental runs see the same numbers.
+ */
+struct FLanGenRandom
+{
+	int32 seed;
+
+	FLanGenRandom(int32 inSeed = 0) : seed(inSeed) {}
+
+	/* two 32 bit keys packed into one index, eg. (stroke, midpoint) */
+	static uint64 Key(uint32 high, uint32 low) { return ((uint64)high << 32) | low; }
+
+	static uint64 Mix(uint64 z)
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	uint64 Bits(uint32 stream, uint64 index) const
+	{
+		uint64 base = Mix(((uint64)(uint32)seed << 32) | stream);
+		return Mix(base + (index + 1) * 0x9E3779B97F4A7C15ull);
+	}
+
+	/* inclusive on both ends like FRandomStream::RandRange; max < min returns min */
+	int32 RandRange(uint32 stream, uint64 index, int32 min, int32 max) const
+	{
+		int64 range = (int64)max - min + 1;
+		if (range <= 0) return min;
+		return min + (int32)(((Bits(stream, index) >> 32) * (uint64)range) >> 32);
+	}
+
+	/* [0, 1) */
+	float FRand(uint32 stream, uint64 index) const { return (Bits(stream, index) >> 40) * (1.0f / 16777216.0f); }
+
+	/* out[i] = RandRange(stream, firstIndex + i, min, max); no loop carried state so it vectorizes */
+	void RandRange(uint32 stream, uint64 firstIndex, int32 min, int32 max, TArrayView<int32> out) const
+	{
+		int64 range = (int64)max - min + 1;
+		uint64 base = Mix(((uint64)(uint32)seed << 32) | stream);
+		if (range <= 0) range = 1;
+		for (int32 i = 0; i < out.Num(); ++i) {
+			uint64 bits = Mix(base + (firstIndex + i + 1) * 0x9E3779B97F4A7C15ull);
+			out[i] = min + (int32)(((bits >> 32) * (uint64)range) >> 32);
+		}
+	}
+};
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Math/Color.h"
+#include "LanGenStats.h"
+#include "LanGenScatterObject.generated.h"
+
+class UStaticMesh;
+class UHierarchicalInstancedStaticMeshComponent;
+class ULanGenDerivedLayerObject;
+class ULanGenElevationObject;
+
+/* one foliage / prop type; density = density * height band * slope band * ridge band * weight */
+USTRUCT(BlueprintType)
+struct LANSCAPEGENERATION_API FLanGenScatterLayer
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		UStaticMesh* mesh = nullptr;
+	/* minimum distance between two instances, pixels */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float radius = 8;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float density = 1;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float minHeight = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float maxHeight = 255;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float heightBlend = 8;
+	/* degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float minSlope = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float maxSlope = 35;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float slopeBlend = 5;
+	/* pixels from the nearest main ridge; only used when ridge points are given */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float minRidgeDistance = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float maxRidgeDistance = 100000;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float ridgeBlend = 16;
+	/* index into the derived layer weightmaps used as a density mask, -1 = none */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		int weightLayer = -1;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float minScale = 0.8;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float maxScale = 1.2;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		bool alignToNormal = false;
+};
+
+/**
+ * Poisson disk scatter over the heightmap.
+ * The map is split in tiles of grid cells; tiles of one of the four 2x2 colours never share a
+ * neighbourhood, so each colour is sampled in parallel while the earlier colours stay fixed.
+ */
+UCLASS(BlueprintType)
+class LANSCAPEGENERATION_API ULanGenScatterObject : public UObject
+{
+	GENERATED_BODY()
+public:
+	/* grid cells per tile side, at least 2 so a disk never reaches past the next tile */
+	static const int TILE_CELLS = 32;
+	/* instances per AddInstances call */
+	static const int BATCH = 16384;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		TArray<FLanGenScatterLayer> layers;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		int32 seed = 0;
+	/* candidates around an active point before it retires */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		int attempts = 30;
+	/* landscape actor transform; pixel x goes to landscape Y and pixel y to landscape X */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		FTransform landscapeTransform;
+	/* local z = R * zPerHeight + zOffset; the defaults match R imported as the high byte of a 16 bit heightmap */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float zPerHeight = 2;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LanGen Scatter")
+		float zOffset = -256;
+private:
+	int lanX = 0, lanY = 0;
+	/* per layer, world space */
+	TArray<TArray<FTransform>> transforms;
+	UPROPERTY(Transient)
+		TArray<UHierarchicalInstancedStaticMeshComponent*> components;
+	FLanGenStats stats;
+public:
+	/* derived and elevation are optional; without them slope comes from the heightmap and ridges are ignored */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Scatter")
+		void Scatter(const TArray<FColor>& heightmap, int x, int y, ULanGenDerivedLayerObject* derived = nullptr, ULanGenElevationObject* elevation = nullptr);
+	/* one instanced component per layer on owner, filled in batches; returns instances added */
+	UFUNCTION(BlueprintCallable, Category = "LanGen Scatter")
+		int SpawnInstances(AActor* owner);
+	UFUNCTION(BlueprintCallable, Category = "LanGen Scatter")
+		void ClearInstances();
+
+	UFUNCTION(BlueprintCallable, Category = "LanGen Scatter")
+		TArray<FTransform> GetTransforms(int layer) const { return transforms.IsValidIndex(layer) ? transforms[layer] : TArray<FTransform>(); }
+	UFUNCTION(BlueprintCallable, Category = "LanGen Scatter")
+		FLanGenStats GetLastStats() const { return stats; }
+private:
+	void ScatterLayer(int layerIndex, const TArray<FColor>& heightmap, const TArray<float>* slope, const TArray<uint8>* weights, const TArray<int32>* ridgeNearest);
+	float HeightAt(const TArray<FColor>& heightmap, float x, float y) const;
+};
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/MemoryBase.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "LanGenStats.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("LanGen"), STATGROUP_LanGen, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RuleApply"), STAT_LanGen_RuleApply, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Turtle Walk"), STAT_LanGen_Turtle, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MidpointDisplacement"), STAT_LanGen_Midpoint, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gradient"), STAT_LanGen_Gradient, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Draw"), STAT_LanGen_Draw, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Noise"), STAT_LanGen_Noise, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Derived Layers"), STAT_LanGen_Derived, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hydrology"), STAT_LanGen_Hydrology, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scatter"), STAT_LanGen_Scatter, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Heightfield Codec"), STAT_LanGen_Heightfield, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Grammar Length"), STAT_LanGen_GrammarLength, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Turtle Ops"), STAT_LanGen_TurtleOps, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Strokes"), STAT_LanGen_Strokes, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pixels Rasterized"), STAT_LanGen_PixelsRasterized, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pixels Written"), STAT_LanGen_PixelsWritten, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Stamps Rejected"), STAT_LanGen_StampsRejected, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Allocations"), STAT_LanGen_Allocations, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Bytes Touched"), STAT_LanGen_BytesTouched, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Arena Bytes"), STAT_LanGen_ArenaBytes, STATGROUP_LanGen, LANSCAPEGENERATION_API);
+
+/**
+ * Per generation breakdown; times are in milliseconds and exclusive,
+ * eg. turtle time does not include the strokes it triggered.
+ */
+USTRUCT(BlueprintType)
+struct LANSCAPEGENERATION_API FLanGenStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		float totalMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		float ruleApplyMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		float turtleMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		float midpointMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		float gradientMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		float drawMs = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		float noiseMs = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 grammarLength = 0;
+	/* ops the grammar compiled to, see FLanGenTurtleProgram */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 turtleOps = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 strokeCount = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 pixelsRasterized = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 pixelsWritten = 0;
+	/* stamps skipped whole because the height pyramid showed they could not win */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 stampsRejected = 0;
+	/* heap allocations during the run, see FLanGenAllocationScope; 0 without STATS */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 allocations = 0;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 bytesTouched = 0;
+	/* scratch bytes held on the mem stack arena when the walk ends, released in one shot */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "LanGen Stats")
+		int64 arenaBytes = 0;
+
+	/* rasterized / written; 1 = no pixel was computed twice */
+	float OverdrawRatio() const { return pixelsWritten > 0 ? (float)pixelsRasterized / pixelsWritten : 0; }
+	void Reset() { *this = FLanGenStats(); }
+	void Append(const FLanGenStats& other);
+	FString ToString() const;
+	/* push counters into the STATGROUP_LanGen counters; add puts them on top of what an earlier stage of the same run published */
+	void Publish(bool add = false) const;
+};
+
+/* adds elapsed milliseconds into target on scope exit */
+struct FLanGenStageTimer
+{
+	float& target;
+	double start;
+	FLanGenStageTimer(float& inTarget) : target(inTarget), start(FPlatformTime::Seconds()) {}
+	~FLanGenStageTimer() { target += (FPlatformTime::Seconds() - start) * 1000.0; }
+};
+
+/*
+* adds the malloc and realloc calls GMalloc saw while in scope into target on scope exit;
+* process wide, so another thread allocating meanwhile counts too, and only STATS builds keep the counters
+*/
+struct FLanGenAllocationScope
+{
+	int64& target;
+#if STATS
+	uint64 start;
+	FLanGenAllocationScope(int64& inTarget) : target(inTarget), start(Count()) {}
+	~FLanGenAllocationScope() { Flush(); }
+	/* adds what was counted so far, eg. before publishing from inside the scope */
+	void Flush() { uint64 now = Count(); target += now - start; start = now; }
+	static uint64 Count() { return FMalloc::TotalMallocCalls + FMalloc::TotalReallocCalls; }
+#else
+	FLanGenAllocationScope(int64& inTarget) : target(inTarget) {}
+	void Flush() {}
+#endif
+};
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LanGenRandom.h"
+
+namespace LanGenTurtleOp
+{
+	enum Type : uint32
+	{
+		/* arg line steps ('F' or 'D') in a row */
+		Move,
+		/* arg net degrees in 1 .. 359; every turn in between is summed and its random draw taken */
+		Turn,
+		/* 'P' */
+		Peak,
+		/* 'L' */
+		Main,
+		/* 'E' */
+		Detail,
+		/* arg branch depth the root is kept at */
+		Push,
+		/* arg depth of the matching push */
+		Pop,
+	};
+}
+
+/**
+ * Expanded grammar compiled once into packed 32 bit ops, 3 bits op and 29 bits arg,
+ * so the walk dispatches once per run instead of once per character.
+ * Symbols the turtle ignores are dropped, a ']' without a '[' is dropped instead of popping an empty stack.
+ */
+struct LANSCAPEGENERATION_API FLanGenTurtleProgram
+{
+	static const uint32 OP_BITS = 3, MAX_ARG = (1u << (32 - OP_BITS)) - 1;
+
+	TArray<uint32> ops;
+	/* characters the ops were compiled from */
+	int64 grammarLength = 0;
+	/* branch roots the walk keeps at once */
+	int maxDepth = 0;
+	/* longest run of line steps before a branch end resets the line */
+	int maxLineSteps = 0;
+
+	/* turns draw from LanGenStream::Turtle keyed by their order in the grammar, same as the walk did */
+	void Compile(const FString& grammar, const FLanGenRandom& random, int minAngle, int maxAngle);
+	/* a step adds at most lineLength points; only a branch end shrinks the line */
+	int MaxLinePoints(int lineLength) const { return (int)FMath::Min((int64)maxLineSteps * FMath::Max(lineLength, 0) + 1, (int64)MAX_int32); }
+
+	static LanGenTurtleOp::Type Op(uint32 in) { return (LanGenTurtleOp::Type)(in & ((1u << OP_BITS) - 1)); }
+	static uint32 Arg(uint32 in) { return in >> OP_BITS; }
+private:
+	void Emit(LanGenTurtleOp::Type op, uint32 arg = 0) { ops.Add(op | arg << OP_BITS); }
+};
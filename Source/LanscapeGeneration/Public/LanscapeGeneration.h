@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+class FLanGenContext;
+
 class FLanscapeGenerationModule : public IModuleInterface
 {
 public:
@@ -12,4 +14,8 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+	FLanGenContext& GetContext() { return *context; }
+private:
+	TUniquePtr<FLanGenContext> context;
 };